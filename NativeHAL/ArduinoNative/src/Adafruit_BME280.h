@@ -0,0 +1,38 @@
+#ifndef ADAFRUIT_BME280_NATIVE_H
+#define ADAFRUIT_BME280_NATIVE_H
+
+// Adafruit_BME280.h (native)
+// Simulated BME280. Temperature comes from `temperatureSource` when set (e.g. a thermal
+// plant model), otherwise from `temperature`. Every read costs one I2C transaction and
+// the virtual time of a real burst read.
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_Sensor.h>
+
+#define BME280_READ_US 600 // typical I2C burst read at 100 kHz
+
+class Adafruit_BME280 {
+public:
+    bool begin(uint8_t addr = 0x77, TwoWire* wire = &Wire) { (void)addr; _wire = wire; return true; }
+
+    float readTemperature() {
+        reads++;
+        _wire->requestFrom(0x77, 3);
+        delayMicroseconds(BME280_READ_US);
+        return temperatureSource ? temperatureSource() : temperature;
+    }
+    float readPressure() { reads++; delayMicroseconds(BME280_READ_US); return pressure; }
+    float readHumidity() { reads++; delayMicroseconds(BME280_READ_US); return humidity; }
+
+    float temperature = 21.0f;
+    float pressure = 101325.0f;
+    float humidity = 40.0f;
+    float (*temperatureSource)(void) = NULL;
+    unsigned long reads = 0;
+
+private:
+    TwoWire* _wire = &Wire;
+};
+
+#endif // ADAFRUIT_BME280_NATIVE_H
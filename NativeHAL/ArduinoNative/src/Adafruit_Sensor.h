@@ -0,0 +1,9 @@
+#ifndef ADAFRUIT_SENSOR_NATIVE_H
+#define ADAFRUIT_SENSOR_NATIVE_H
+
+// Adafruit_Sensor.h (native)
+// Only included for its side effects by the BME280 driver; nothing to simulate.
+
+#include <Arduino.h>
+
+#endif // ADAFRUIT_SENSOR_NATIVE_H
@@ -0,0 +1,373 @@
+// Arduino.cpp (native)
+// Virtual clock, simulated pins/interrupts/timers, Serial and the program entry point.
+
+#include "Arduino.h"
+
+#include <deque>
+#include <vector>
+#include <unistd.h>
+#include <fcntl.h>
+
+#ifndef NATIVE_LOOP_US
+#define NATIVE_LOOP_US 10 // virtual time consumed by one loop() pass
+#endif
+
+HardwareSerial Serial;
+
+namespace hal {
+    void (*pinWriteHook)(uint8_t pin, uint8_t level) = NULL;
+    int (*pinReadHook)(uint8_t pin) = NULL;
+    unsigned long digitalReads = 0;
+    unsigned long digitalWrites = 0;
+    unsigned long analogReads = 0;
+}
+
+namespace {
+    uint64_t clockMicros = 0;
+    uint64_t runDeadline = UINT64_MAX; // end of the run, so blocking loops in setup() terminate too
+    unsigned clockReadCost = 1;
+    bool irqEnabled = true;
+
+    uint8_t pinModes[NATIVE_PIN_COUNT];
+    int pinLevels[NATIVE_PIN_COUNT];
+    bool pinDriven[NATIVE_PIN_COUNT];
+    int analogValues[NATIVE_PIN_COUNT];
+
+    struct Isr {
+        voidFuncPtr fn;
+        int mode;
+    };
+    Isr isrs[NATIVE_PIN_COUNT];
+
+    struct Periodic {
+        uint64_t period;
+        uint64_t next;
+        bool enabled;
+        bool autoreload;
+        bool latched; // came due with interrupts disabled; fires when they are enabled
+        void (*fn)(void);
+    };
+    std::vector<Periodic*> periodics;
+
+    std::deque<char> serialInput;
+    bool stdinEnabled = true;
+    bool stdinOpen = true;
+
+    int readPin(uint8_t pin) {
+        if (pin >= NATIVE_PIN_COUNT) return LOW;
+        if (hal::pinReadHook) {
+            int v = hal::pinReadHook(pin);
+            if (v >= 0) return v ? HIGH : LOW;
+        }
+        if (pinDriven[pin] || pinModes[pin] == OUTPUT) return pinLevels[pin];
+        return pinModes[pin] == INPUT_PULLUP ? HIGH : LOW;
+    }
+
+    void checkDeadline() {
+        if (clockMicros < runDeadline) return;
+        fflush(stdout);
+        exit(0);
+    }
+
+    void pollStdin() {
+        if (!stdinEnabled || !stdinOpen) return;
+        static bool nonBlocking = false;
+        if (!nonBlocking) {
+            int flags = fcntl(STDIN_FILENO, F_GETFL, 0);
+            fcntl(STDIN_FILENO, F_SETFL, flags | O_NONBLOCK);
+            nonBlocking = true;
+        }
+        char buf[256];
+        ssize_t n = ::read(STDIN_FILENO, buf, sizeof(buf));
+        if (n == 0) stdinOpen = false;
+        for (ssize_t i = 0; i < n; i++) serialInput.push_back(buf[i]);
+    }
+}
+
+struct hw_timer_t {
+    Periodic p;
+    uint16_t divider;
+};
+
+// ---------------------------------------------------------------------------
+// Clock
+
+namespace hal {
+    uint64_t nowMicros() { return clockMicros; }
+
+    bool inCallback = false;
+
+    void advanceMicros(uint64_t us) {
+        if (inCallback) {
+            // Time spent inside a timer callback (e.g. bus transactions): no nested firing
+            clockMicros += us;
+            return;
+        }
+        uint64_t end = clockMicros + us;
+        // Fire due periodic callbacks in time order
+        for (;;) {
+            Periodic* due = NULL;
+            for (size_t i = 0; i < periodics.size(); i++) {
+                Periodic* p = periodics[i];
+                if (p->enabled && p->fn && p->next <= end && (!due || p->next < due->next)) due = p;
+            }
+            if (!due) break;
+            if (due->next > clockMicros) clockMicros = due->next;
+            if (due->autoreload) due->next += due->period;
+            else due->enabled = false;
+            if (irqEnabled) {
+                inCallback = true;
+                due->fn();
+                inCallback = false;
+            } else {
+                due->latched = true; // like an interrupt flag: periods missed meanwhile coalesce
+            }
+        }
+        if (end > clockMicros) clockMicros = end;
+        checkDeadline();
+    }
+
+    void setClockReadCost(unsigned us) { clockReadCost = us; }
+
+    void every(uint32_t periodUs, void (*fn)(void)) {
+        Periodic* p = new Periodic();
+        p->period = periodUs ? periodUs : 1;
+        p->next = clockMicros + p->period;
+        p->enabled = true;
+        p->autoreload = true;
+        p->latched = false;
+        p->fn = fn;
+        periodics.push_back(p);
+    }
+
+    void setPin(uint8_t pin, int level) {
+        if (pin >= NATIVE_PIN_COUNT) return;
+        int old = readPin(pin);
+        pinLevels[pin] = level ? HIGH : LOW;
+        pinDriven[pin] = true;
+        int now = readPin(pin);
+        Isr& isr = isrs[pin];
+        if (isr.fn && irqEnabled && old != now) {
+            if (isr.mode == CHANGE || (isr.mode == RISING && now == HIGH) || (isr.mode == FALLING && now == LOW)) {
+                isr.fn();
+            }
+        }
+    }
+
+    int pinLevel(uint8_t pin) { return pin < NATIVE_PIN_COUNT ? pinLevels[pin] : LOW; }
+    void setAnalog(uint8_t pin, int value) { if (pin < NATIVE_PIN_COUNT) analogValues[pin] = value; }
+
+    void serialInject(const char* text) {
+        while (text && *text) serialInput.push_back(*text++);
+    }
+    void useStdin(bool enabled) { stdinEnabled = enabled; }
+
+    void setInterrupts(bool enabled) {
+        irqEnabled = enabled;
+        if (!enabled || inCallback) return;
+        for (size_t i = 0; i < periodics.size(); i++) {
+            Periodic* p = periodics[i];
+            if (!p->latched || !p->fn) continue;
+            p->latched = false;
+            inCallback = true;
+            p->fn();
+            inCallback = false;
+        }
+    }
+    bool interruptsEnabled() { return irqEnabled; }
+}
+
+unsigned long micros() {
+    clockMicros += clockReadCost;
+    checkDeadline();
+    return (unsigned long)clockMicros;
+}
+
+unsigned long millis() {
+    clockMicros += clockReadCost;
+    checkDeadline();
+    return (unsigned long)(clockMicros / 1000);
+}
+
+void delay(unsigned long ms) { hal::advanceMicros((uint64_t)ms * 1000); }
+void delayMicroseconds(unsigned int us) { hal::advanceMicros(us); }
+void yield() { hal::advanceMicros(1); }
+
+// ---------------------------------------------------------------------------
+// Pins
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < NATIVE_PIN_COUNT) pinModes[pin] = mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    hal::digitalWrites++;
+    if (pin >= NATIVE_PIN_COUNT) return;
+    pinLevels[pin] = val ? HIGH : LOW;
+    if (hal::pinWriteHook) hal::pinWriteHook(pin, val ? HIGH : LOW);
+}
+
+int digitalRead(uint8_t pin) {
+    hal::digitalReads++;
+    return readPin(pin);
+}
+
+int analogRead(uint8_t pin) {
+    hal::analogReads++;
+    return pin < NATIVE_PIN_COUNT ? analogValues[pin] : 0;
+}
+
+void analogWrite(uint8_t pin, int val) {
+    if (pin < NATIVE_PIN_COUNT) pinLevels[pin] = val;
+}
+
+void analogReadResolution(int) {}
+
+void attachInterrupt(uint8_t interruptNum, voidFuncPtr isr, int mode) {
+    if (interruptNum >= NATIVE_PIN_COUNT) return;
+    isrs[interruptNum].fn = isr;
+    isrs[interruptNum].mode = mode;
+}
+
+void detachInterrupt(uint8_t interruptNum) {
+    if (interruptNum < NATIVE_PIN_COUNT) isrs[interruptNum].fn = NULL;
+}
+
+long random(long howbig) { return howbig > 0 ? rand() % howbig : 0; }
+long random(long howsmall, long howbig) { return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall); }
+void randomSeed(unsigned long seed) { srand((unsigned)seed); }
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+// ---------------------------------------------------------------------------
+// ESP32 timers: 80 MHz APB clock divided by `divider`
+
+hw_timer_t* timerBegin(uint8_t, uint16_t divider, bool) {
+    hw_timer_t* t = new hw_timer_t();
+    t->divider = divider ? divider : 1;
+    t->p.enabled = false;
+    t->p.autoreload = true;
+    t->p.period = 1;
+    t->p.fn = NULL;
+    periodics.push_back(&t->p);
+    return t;
+}
+void timerEnd(hw_timer_t* timer) { if (timer) timer->p.enabled = false; }
+void timerAttachInterrupt(hw_timer_t* timer, void (*fn)(void), bool) { if (timer) timer->p.fn = fn; }
+void timerDetachInterrupt(hw_timer_t* timer) { if (timer) timer->p.fn = NULL; }
+void timerAlarmWrite(hw_timer_t* timer, uint64_t alarmValue, bool autoreload) {
+    if (!timer) return;
+    uint64_t us = alarmValue * timer->divider / 80;
+    timer->p.period = us ? us : 1;
+    timer->p.autoreload = autoreload;
+}
+void timerAlarmEnable(hw_timer_t* timer) {
+    if (!timer) return;
+    timer->p.enabled = true;
+    timer->p.next = clockMicros + timer->p.period;
+}
+void timerAlarmDisable(hw_timer_t* timer) { if (timer) timer->p.enabled = false; }
+
+// ---------------------------------------------------------------------------
+// Serial
+
+int HardwareSerial::available() {
+    if (serialInput.empty()) pollStdin();
+    return (int)serialInput.size();
+}
+
+int HardwareSerial::read() {
+    if (serialInput.empty()) pollStdin();
+    if (serialInput.empty()) return -1;
+    char c = serialInput.front();
+    serialInput.pop_front();
+    return (unsigned char)c;
+}
+
+int HardwareSerial::peek() {
+    if (serialInput.empty()) pollStdin();
+    return serialInput.empty() ? -1 : (unsigned char)serialInput.front();
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    putchar(c);
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Print
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+}
+size_t Print::write(const char* str) { return str ? write((const uint8_t*)str, strlen(str)) : 0; }
+
+size_t Print::_printNumber(unsigned long long n, int base) {
+    char buf[8 * sizeof(unsigned long long) + 1];
+    char* p = &buf[sizeof(buf) - 1];
+    *p = '\0';
+    if (base < 2) base = 10;
+    do {
+        int d = (int)(n % base);
+        *--p = (char)(d < 10 ? '0' + d : 'A' + d - 10);
+        n /= base;
+    } while (n);
+    return write(p);
+}
+
+size_t Print::_printSigned(long long n, int base) {
+    if (base == 10 && n < 0) return write('-') + _printNumber((unsigned long long)(-n), base);
+    return _printNumber((unsigned long long)n, base);
+}
+
+size_t Print::print(const __FlashStringHelper* s) { return write(reinterpret_cast<const char*>(s)); }
+size_t Print::print(const String& s) { return write(s.c_str()); }
+size_t Print::print(const char* s) { return write(s); }
+size_t Print::print(char c) { return write((uint8_t)c); }
+size_t Print::print(unsigned char n, int base) { return _printNumber(n, base); }
+size_t Print::print(int n, int base) { return _printSigned(n, base); }
+size_t Print::print(unsigned int n, int base) { return _printNumber(n, base); }
+size_t Print::print(long n, int base) { return _printSigned(n, base); }
+size_t Print::print(unsigned long n, int base) { return _printNumber(n, base); }
+size_t Print::print(long long n, int base) { return _printSigned(n, base); }
+size_t Print::print(unsigned long long n, int base) { return _printNumber(n, base); }
+size_t Print::print(double n, int digits) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", digits, n);
+    return write(buf);
+}
+
+size_t Print::println() { return write('\r') + write('\n'); }
+size_t Print::println(const __FlashStringHelper* s) { return print(s) + println(); }
+size_t Print::println(const String& s) { return print(s) + println(); }
+size_t Print::println(const char* s) { return print(s) + println(); }
+size_t Print::println(char c) { return print(c) + println(); }
+size_t Print::println(unsigned char n, int base) { return print(n, base) + println(); }
+size_t Print::println(int n, int base) { return print(n, base) + println(); }
+size_t Print::println(unsigned int n, int base) { return print(n, base) + println(); }
+size_t Print::println(long n, int base) { return print(n, base) + println(); }
+size_t Print::println(unsigned long n, int base) { return print(n, base) + println(); }
+size_t Print::println(long long n, int base) { return print(n, base) + println(); }
+size_t Print::println(unsigned long long n, int base) { return print(n, base) + println(); }
+size_t Print::println(double n, int digits) { return print(n, digits) + println(); }
+
+// ---------------------------------------------------------------------------
+// Entry point: run setup() once, then loop() until the requested virtual time has
+// elapsed (first argument, seconds; default 10). The deadline also covers setup(), so a
+// sketch blocked waiting on an input nobody drives still exits. Unit tests
+// (PIO_UNIT_TESTING, set by `pio test`) bring their own main().
+
+#if !defined(NATIVE_HAL_NO_MAIN) && !defined(PIO_UNIT_TESTING)
+int main(int argc, char** argv) {
+    double seconds = (argc > 1) ? atof(argv[1]) : 10.0;
+    runDeadline = (uint64_t)(seconds * 1000000.0);
+    setup();
+    for (;;) {
+        loop();
+        hal::advanceMicros(NATIVE_LOOP_US);
+    }
+}
+#endif
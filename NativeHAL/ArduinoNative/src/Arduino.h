@@ -0,0 +1,164 @@
+#ifndef ARDUINO_NATIVE_H
+#define ARDUINO_NATIVE_H
+
+// Arduino.h (native)
+// Host-side stand-in for the Arduino core so the demo projects can be built and run on
+// Linux with `pio run -e native`. Time is virtual: it only moves when delay() or
+// delayMicroseconds() is called, by 1 us on every micros()/millis() read (so polling
+// loops make progress), and by NATIVE_LOOP_US after every loop() pass.
+// Pins, interrupts and timers are simulated; see the hal:: namespace for the hooks a
+// simulation can use to drive inputs and observe outputs.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <ctype.h>
+#include <string>
+#include <type_traits>
+
+#include "WString.h"
+#include "Print.h"
+
+#define NATIVE_HAL 1
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT          0x0
+#define OUTPUT         0x1
+#define INPUT_PULLUP   0x2
+#define INPUT_PULLDOWN 0x3
+
+#define CHANGE  1
+#define FALLING 2
+#define RISING  3
+
+#define PI 3.1415926535897932384626433832795
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+
+#define NATIVE_PIN_COUNT 64
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+#define pgm_read_float(addr) (*(const float*)(addr))
+#define IRAM_ATTR
+
+#define digitalPinToInterrupt(p) (p)
+#define noInterrupts() hal::setInterrupts(false)
+#define interrupts() hal::setInterrupts(true)
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bit(b) (1UL << (b))
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef void (*voidFuncPtr)(void);
+
+// By value: the conditional on two lvalues would otherwise return a reference to a parameter
+template <class A, class B> inline typename std::common_type<A, B>::type min(A a, B b) { return a < b ? a : b; }
+template <class A, class B> inline typename std::common_type<A, B>::type max(A a, B b) { return a > b ? a : b; }
+
+// Sketch entry points
+void setup();
+void loop();
+
+// Core API
+unsigned long micros();
+unsigned long millis();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int val);
+void analogReadResolution(int bits);
+
+void attachInterrupt(uint8_t interruptNum, voidFuncPtr isr, int mode);
+void detachInterrupt(uint8_t interruptNum);
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+// ESP32 style hardware timers (Week2Friday), fired from the virtual clock
+struct hw_timer_t;
+hw_timer_t* timerBegin(uint8_t num, uint16_t divider, bool countUp);
+void timerEnd(hw_timer_t* timer);
+void timerAttachInterrupt(hw_timer_t* timer, void (*fn)(void), bool edge);
+void timerDetachInterrupt(hw_timer_t* timer);
+void timerAlarmWrite(hw_timer_t* timer, uint64_t alarmValue, bool autoreload);
+void timerAlarmEnable(hw_timer_t* timer);
+void timerAlarmDisable(hw_timer_t* timer);
+
+// Serial port: output goes to stdout, input comes from stdin and hal::serialInject()
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long baud) { _baud = baud; }
+    void end() {}
+    int available();
+    int read();
+    int peek();
+    void flush() { fflush(stdout); }
+    size_t write(uint8_t c);
+    using Print::write;
+    int availableForWrite() { return 64; } // output is not rate limited on the host
+    operator bool() const { return true; }
+    unsigned long baud() const { return _baud; }
+private:
+    unsigned long _baud = 0;
+};
+extern HardwareSerial Serial;
+
+// Simulation hooks
+namespace hal {
+    // Virtual clock
+    uint64_t nowMicros();
+    void advanceMicros(uint64_t us);       // moves time forward, firing due timers
+    void setClockReadCost(unsigned us);     // time consumed by each micros()/millis() read
+
+    // Pins. Input levels default to the pull resistor (HIGH for INPUT_PULLUP).
+    void setPin(uint8_t pin, int level);    // drive an input (fires attached interrupts)
+    int pinLevel(uint8_t pin);              // last level written to / driven on a pin
+    void setAnalog(uint8_t pin, int value);
+    extern void (*pinWriteHook)(uint8_t pin, uint8_t level); // observe digitalWrite()
+    extern int (*pinReadHook)(uint8_t pin);                  // model inputs; return -1 to fall back
+
+    // Periodic callback driven by the virtual clock (stand-in for a timer interrupt)
+    void every(uint32_t periodUs, void (*fn)(void));
+
+    // Serial input
+    void serialInject(const char* text);
+    void useStdin(bool enabled);
+
+    // noInterrupts()/interrupts(). A timer callback that comes due while interrupts are
+    // disabled is held, like a pending interrupt flag, and runs once when they are enabled.
+    void setInterrupts(bool enabled);
+    bool interruptsEnabled();
+
+    // Counters for benchmarking
+    extern unsigned long digitalReads;
+    extern unsigned long digitalWrites;
+    extern unsigned long analogReads;
+}
+
+#endif // ARDUINO_NATIVE_H
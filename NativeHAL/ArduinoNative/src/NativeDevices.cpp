@@ -0,0 +1,10 @@
+// NativeDevices.cpp (native)
+// Global device instances that the real Arduino libraries provide.
+
+#include "P1AM.h"
+#include "Wire.h"
+#include "SPI.h"
+
+P1AM_Native P1;
+TwoWire Wire;
+SPIClass SPI;
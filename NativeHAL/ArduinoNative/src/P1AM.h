@@ -0,0 +1,87 @@
+#ifndef P1AM_NATIVE_H
+#define P1AM_NATIVE_H
+
+// P1AM.h (native)
+// Simulated P1AM base controller. Every read/write is one backplane transaction and is
+// counted in `transactions`. As on the real library, channel 0 addresses the whole
+// module: readDiscrete(slot) returns all inputs as a bitmask (bit 0 = channel 1) and
+// writeDiscrete(mask, slot) sets every output at once. Each transaction also costs
+// P1AM_TRANSACTION_US of virtual time, like the SPI exchange with the base controller.
+
+#include <Arduino.h>
+
+#define P1AM_NATIVE_SLOTS 16
+#define P1AM_NATIVE_CHANNELS 32
+
+#ifndef P1AM_TRANSACTION_US
+#define P1AM_TRANSACTION_US 20
+#endif
+
+class P1AM_Native {
+public:
+    uint8_t init() { return 3; } // number of modules found
+
+    uint32_t readDiscrete(uint8_t slot, uint8_t channel = 0) {
+        _transaction();
+        uint32_t inputs = _inputMask(slot);
+        if (channel == 0) return inputs;
+        return (inputs >> (channel - 1)) & 1UL;
+    }
+
+    void writeDiscrete(uint32_t data, uint8_t slot, uint8_t channel = 0) {
+        _transaction();
+        if (slot >= P1AM_NATIVE_SLOTS) return;
+        if (channel == 0) outputs[slot] = data;
+        else if (data) outputs[slot] |= (1UL << (channel - 1));
+        else outputs[slot] &= ~(1UL << (channel - 1));
+        if (outputHook) outputHook(slot, outputs[slot]);
+    }
+
+    int readAnalog(uint8_t slot, uint8_t channel) {
+        _transaction();
+        if (analogHook) return analogHook(slot, channel);
+        if (slot >= P1AM_NATIVE_SLOTS || channel == 0 || channel > P1AM_NATIVE_CHANNELS) return 0;
+        return analog[slot][channel - 1];
+    }
+
+    void writeAnalog(uint32_t data, uint8_t slot, uint8_t channel) {
+        _transaction();
+        if (slot < P1AM_NATIVE_SLOTS && channel >= 1 && channel <= P1AM_NATIVE_CHANNELS) analog[slot][channel - 1] = (int)data;
+    }
+
+    // --- simulation side ---
+    void setInput(uint8_t slot, uint8_t channel, bool level) {
+        if (slot >= P1AM_NATIVE_SLOTS || channel == 0) return;
+        if (level) inputs[slot] |= (1UL << (channel - 1));
+        else inputs[slot] &= ~(1UL << (channel - 1));
+    }
+    bool output(uint8_t slot, uint8_t channel) const {
+        return slot < P1AM_NATIVE_SLOTS && channel >= 1 && ((outputs[slot] >> (channel - 1)) & 1UL);
+    }
+
+    uint32_t inputs[P1AM_NATIVE_SLOTS] = {0};
+    uint32_t outputs[P1AM_NATIVE_SLOTS] = {0};
+    int analog[P1AM_NATIVE_SLOTS][P1AM_NATIVE_CHANNELS] = {{0}};
+    unsigned long transactions = 0;
+
+    // Optional models: compute a module's inputs / an analog channel on every read,
+    // and observe output changes.
+    uint32_t (*inputHook)(uint8_t slot) = NULL;
+    int (*analogHook)(uint8_t slot, uint8_t channel) = NULL;
+    void (*outputHook)(uint8_t slot, uint32_t outputs) = NULL;
+
+private:
+    void _transaction() {
+        transactions++;
+        hal::advanceMicros(P1AM_TRANSACTION_US);
+    }
+
+    uint32_t _inputMask(uint8_t slot) {
+        if (inputHook) return inputHook(slot);
+        return slot < P1AM_NATIVE_SLOTS ? inputs[slot] : 0;
+    }
+};
+
+extern P1AM_Native P1;
+
+#endif // P1AM_NATIVE_H
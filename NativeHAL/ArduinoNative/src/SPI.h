@@ -0,0 +1,17 @@
+#ifndef SPI_NATIVE_H
+#define SPI_NATIVE_H
+
+// SPI.h (native)
+
+#include <Arduino.h>
+
+class SPIClass {
+public:
+    void begin() {}
+    void end() {}
+    uint8_t transfer(uint8_t) { return 0; }
+};
+
+extern SPIClass SPI;
+
+#endif // SPI_NATIVE_H
@@ -0,0 +1,187 @@
+#ifndef SPARKFUN_BMI270_NATIVE_H
+#define SPARKFUN_BMI270_NATIVE_H
+
+// SparkFun_BMI270_Arduino_Library.h (native)
+// Simulated BMI270. getSensorData() fills `data` from `sampleSource` when set
+// (e.g. a recorded trace), otherwise it reports the device lying flat and still.
+//
+// The FIFO is modelled in stream mode: one accel+gyro frame per ODR period, the oldest
+// frames overwritten once `fifoCapacity` are queued. Frames are generated when they are
+// read, with `sampleTimeMicros` set to the time the frame was taken. When the simulation
+// sets `fifoInterruptPin`, that pin follows the (non-latched) watermark interrupt.
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#define BMI2_OK 0
+#define BMI2_E_COM_FAIL -2
+#define BMI2_I2C_PRIM_ADDR 0x68
+#define BMI2_I2C_SEC_ADDR 0x69
+
+#define BMI2_ACC_ODR_100HZ 0x08
+#define BMI2_ACC_ODR_200HZ 0x09
+#define BMI2_ACC_ODR_400HZ 0x0A
+#define BMI2_GYR_ODR_100HZ 0x08
+#define BMI2_GYR_ODR_200HZ 0x09
+#define BMI2_GYR_ODR_400HZ 0x0A
+
+#define BMI2_DISABLE 0
+#define BMI2_ENABLE 1
+#define BMI2_FIFO_ACC_EN 0x0040
+#define BMI2_FIFO_GYR_EN 0x0080
+
+#define BMI2_INT_NON_LATCH 0
+#define BMI2_INT_ACTIVE_HIGH 1
+#define BMI2_INT_PUSH_PULL 0
+#define BMI2_INT_OUTPUT_ENABLE 1
+#define BMI2_INT_INPUT_DISABLE 0
+
+enum bmi2_hw_int_pin { BMI2_INT_NONE, BMI2_INT1, BMI2_INT2, BMI2_INT_BOTH };
+enum bmi2_sens_int_types { BMI2_FFULL_INT = 13, BMI2_FWM_INT = 14, BMI2_DRDY_INT = 15 };
+
+struct bmi2_int_pin_cfg {
+    uint8_t lvl, od, output_en, input_en;
+};
+struct bmi2_int_pin_config {
+    uint8_t pin_type;
+    uint8_t int_latch;
+    bmi2_int_pin_cfg pin_cfg[2];
+};
+
+struct BMI270_FIFOConfig {
+    uint16_t flags;
+    uint16_t watermark;       // frames
+    uint8_t accelDownSample;
+    uint8_t gyroDownSample;
+    uint8_t accelFilter;
+    uint8_t gyroFilter;
+    uint8_t selfWakeUp;
+};
+
+struct BMI270_SensorData {
+    float accelX, accelY, accelZ; // g
+    float gyroX, gyroY, gyroZ;    // deg/s
+    uint32_t sensorTimeMillis;
+};
+
+class BMI270 {
+public:
+    int8_t beginI2C(uint8_t address = BMI2_I2C_PRIM_ADDR, TwoWire& wire = Wire) { (void)address; _wire = &wire; return BMI2_OK; }
+
+    int8_t setAccelODR(uint8_t odr) { accelOdr = odr; return BMI2_OK; }
+    int8_t setGyroODR(uint8_t odr) { gyroOdr = odr; return BMI2_OK; }
+
+    int8_t getSensorData() {
+        reads++;
+        _wire->requestFrom(BMI2_I2C_PRIM_ADDR, 12);
+        sampleTimeMicros = hal::nowMicros();
+        _sample(data);
+        return BMI2_OK;
+    }
+
+    int8_t setFIFOConfig(BMI270_FIFOConfig config) {
+        _fifoOn = (config.flags & (BMI2_FIFO_ACC_EN | BMI2_FIFO_GYR_EN)) != 0;
+        _fifoWatermark = config.watermark;
+        flushFIFO();
+        if (fifoInterruptPin >= 0 && !_tickerStarted) {
+            _active() = this;
+            hal::every(_periodMicros(), _tick);
+            _tickerStarted = true;
+        }
+        return BMI2_OK;
+    }
+
+    int8_t flushFIFO() {
+        _fifoEpoch = hal::nowMicros();
+        _fifoTaken = 0;
+        return BMI2_OK;
+    }
+
+    // Frames queued
+    int8_t getFIFOLength(uint16_t* numData) {
+        _wire->requestFrom(BMI2_I2C_PRIM_ADDR, 2);
+        *numData = _fifoLevel();
+        return BMI2_OK;
+    }
+
+    // Up to *numData frames into data[]; *numData is set to the number read
+    int8_t getFIFOData(BMI270_SensorData* out, uint16_t* numData) {
+        _wire->requestFrom(BMI2_I2C_PRIM_ADDR, 2);
+        uint16_t n = _fifoLevel();
+        if (n > *numData) n = *numData;
+        // Frames of 13 bytes (header + accel + gyro), read in 128-byte bus transfers
+        for (unsigned long left = n * 13UL; left > 0; left -= left > 128 ? 128 : left) {
+            _wire->requestFrom(BMI2_I2C_PRIM_ADDR, (uint8_t)(left > 128 ? 128 : left));
+        }
+        for (uint16_t i = 0; i < n; i++) {
+            _fifoTaken++;
+            sampleTimeMicros = _fifoEpoch + _fifoTaken * _periodMicros();
+            _sample(out[i]);
+        }
+        *numData = n;
+        fifoFrames += n;
+        return BMI2_OK;
+    }
+
+    int8_t setInterruptPinConfig(bmi2_int_pin_config config) { (void)config; return BMI2_OK; }
+    int8_t mapInterruptToPin(uint8_t interruptType, bmi2_hw_int_pin pin) { (void)interruptType; (void)pin; return BMI2_OK; }
+
+    BMI270_SensorData data = {};
+    void (*sampleSource)(BMI270_SensorData& out) = NULL;
+    unsigned long reads = 0;
+    uint8_t accelOdr = BMI2_ACC_ODR_100HZ;
+    uint8_t gyroOdr = BMI2_GYR_ODR_100HZ;
+
+    uint64_t sampleTimeMicros = 0; // time of the frame being generated
+    uint16_t fifoCapacity = 157;   // 2 KB of 13-byte frames
+    int fifoInterruptPin = -1;     // MCU pin wired to INT1, set by the simulation
+    unsigned long fifoFrames = 0;  // frames read from the FIFO
+    unsigned long fifoOverwritten = 0;
+
+private:
+    TwoWire* _wire = &Wire;
+    bool _fifoOn = false;
+    uint16_t _fifoWatermark = 0;
+    uint64_t _fifoEpoch = 0;
+    uint64_t _fifoTaken = 0;       // frames consumed (read or overwritten) since the epoch
+    bool _tickerStarted = false;
+
+    uint32_t _periodMicros() const {
+        int shift = (int)accelOdr - 8; // 0x08 is 100 Hz, each step doubles
+        double hz = shift >= 0 ? 100.0 * (1 << shift) : 100.0 / (1 << -shift);
+        return (uint32_t)(1000000.0 / hz);
+    }
+
+    uint16_t _fifoLevel() {
+        if (!_fifoOn) return 0;
+        uint64_t produced = (hal::nowMicros() - _fifoEpoch) / _periodMicros();
+        if (produced - _fifoTaken > fifoCapacity) {
+            fifoOverwritten += (unsigned long)(produced - _fifoTaken - fifoCapacity);
+            _fifoTaken = produced - fifoCapacity;
+        }
+        return (uint16_t)(produced - _fifoTaken);
+    }
+
+    void _sample(BMI270_SensorData& out) {
+        out.sensorTimeMillis = (uint32_t)(sampleTimeMicros / 1000);
+        if (sampleSource) {
+            sampleSource(out);
+        } else {
+            out.accelX = 0.0f; out.accelY = 0.0f; out.accelZ = 1.0f;
+            out.gyroX = 0.0f; out.gyroY = 0.0f; out.gyroZ = 0.0f;
+        }
+    }
+
+    static BMI270*& _active() {
+        static BMI270* imu = NULL;
+        return imu;
+    }
+    static void _tick() {
+        BMI270* imu = _active();
+        if (!imu || imu->fifoInterruptPin < 0) return;
+        bool high = imu->_fifoWatermark && imu->_fifoLevel() >= imu->_fifoWatermark;
+        hal::setPin((uint8_t)imu->fifoInterruptPin, high ? HIGH : LOW);
+    }
+};
+
+#endif // SPARKFUN_BMI270_NATIVE_H
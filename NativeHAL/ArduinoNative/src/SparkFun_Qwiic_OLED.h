@@ -0,0 +1,142 @@
+#ifndef SPARKFUN_QWIIC_OLED_NATIVE_H
+#define SPARKFUN_QWIIC_OLED_NATIVE_H
+
+// SparkFun_Qwiic_OLED.h (native)
+// SSD1306 stand-in with a real 1-bit page framebuffer (8-pixel-high pages, one byte per
+// column). Like the SparkFun driver, every pixel write widens its page's dirty column
+// range, and display() sends only the dirty range of each page and then clears it.
+// display() counts the bytes it would send over I2C so render strategies can be
+// compared; text() only marks the glyph cells (5x7 font in 6x8 cells).
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#define SCROLL_INTERVAL_5_FRAMES   0x00
+#define SCROLL_INTERVAL_64_FRAMES  0x01
+#define SCROLL_INTERVAL_128_FRAMES 0x02
+#define SCROLL_INTERVAL_256_FRAMES 0x03
+#define SCROLL_INTERVAL_3_FRAMES   0x04
+#define SCROLL_INTERVAL_4_FRAMES   0x05
+#define SCROLL_INTERVAL_25_FRAMES  0x06
+#define SCROLL_INTERVAL_2_FRAMES   0x07
+
+#define COLOR_BLACK 0
+#define COLOR_WHITE 1
+
+struct QwiicFont {
+    uint8_t width;
+    uint8_t height;
+};
+
+template <uint8_t W, uint8_t H>
+class QwiicOLEDNative {
+public:
+    bool begin(TwoWire& wire = Wire, uint8_t address = 0x3D) { (void)wire; (void)address; erase(); return true; }
+    uint8_t getWidth() const { return W; }
+    uint8_t getHeight() const { return H; }
+    const QwiicFont* getFont() const { return &_font; }
+
+    void erase() {
+        memset(_buffer, 0, sizeof(_buffer));
+        for (uint8_t p = 0; p < H / 8; p++) _markPage(p, 0, W);
+    }
+
+    void pixel(uint8_t x, uint8_t y, uint8_t color = COLOR_WHITE) {
+        if (x >= W || y >= H) return;
+        _markPage(y / 8, x, x + 1);
+        uint8_t& b = _buffer[y / 8][x];
+        if (color) b |= (uint8_t)(1 << (y & 7));
+        else b &= (uint8_t)~(1 << (y & 7));
+    }
+    void line(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t color = COLOR_WHITE) {
+        int dx = abs(x1 - x0), dy = -abs(y1 - y0);
+        int sx = x0 < x1 ? 1 : -1, sy = y0 < y1 ? 1 : -1, err = dx + dy;
+        int x = x0, y = y0;
+        for (;;) {
+            pixel((uint8_t)x, (uint8_t)y, color);
+            if (x == x1 && y == y1) break;
+            int e2 = 2 * err;
+            if (e2 >= dy) { err += dy; x += sx; }
+            if (e2 <= dx) { err += dx; y += sy; }
+        }
+    }
+    void rectangleFill(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t color = COLOR_WHITE) {
+        for (uint8_t j = 0; j < h; j++)
+            for (uint8_t i = 0; i < w; i++) pixel(x + i, y + j, color);
+    }
+    void rectangle(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t color = COLOR_WHITE) {
+        if (w == 0 || h == 0) return;
+        line(x, y, x + w - 1, y, color);
+        line(x, y + h - 1, x + w - 1, y + h - 1, color);
+        line(x, y, x, y + h - 1, color);
+        line(x + w - 1, y, x + w - 1, y + h - 1, color);
+    }
+
+    void text(uint8_t x, uint8_t y, const char* str, uint8_t color = COLOR_WHITE) {
+        for (; str && *str; str++, x += _font.width + 1) {
+            if (*str == ' ') continue;
+            // Glyph stand-in: a pattern derived from the character code
+            for (uint8_t i = 0; i < _font.width; i++) {
+                uint8_t bits = (uint8_t)((*str * (i + 3)) | 0x41);
+                for (uint8_t j = 0; j < 7; j++)
+                    if (bits & (1 << j)) pixel(x + i, y + j, color);
+            }
+        }
+    }
+    void text(uint8_t x, uint8_t y, const String& str, uint8_t color = COLOR_WHITE) { text(x, y, str.c_str(), color); }
+
+    // Send the dirty column range of each page to the panel
+    void display() {
+        displayCalls++;
+        for (uint8_t p = 0; p < H / 8; p++) {
+            if (_dirty1[p] <= _dirty0[p]) continue;
+            _send(p, _dirty0[p], _dirty1[p]);
+            _dirty0[p] = W;
+            _dirty1[p] = 0;
+        }
+    }
+
+    void scrollStop() {}
+    void scrollRight(uint8_t, uint8_t, uint8_t) {}
+    void scrollVertRight(uint8_t, uint8_t, uint8_t) {}
+    void scrollLeft(uint8_t, uint8_t, uint8_t) {}
+    void scrollVertLeft(uint8_t, uint8_t, uint8_t) {}
+    void flipHorizontal(bool) {}
+    void flipVertical(bool) {}
+    void invert(bool) {}
+
+    const uint8_t* page(uint8_t p) const { return _buffer[p]; }   // panel framebuffer rows
+    const uint8_t* shownPage(uint8_t p) const { return _panel[p]; } // what the panel shows
+
+    unsigned long displayCalls = 0;
+    unsigned long bytesSent = 0;
+
+private:
+    uint8_t _buffer[H / 8][W];
+    uint8_t _panel[H / 8][W];
+    uint8_t _dirty0[H / 8] = {}; // dirty columns of each page, [_dirty0, _dirty1)
+    uint8_t _dirty1[H / 8] = {};
+    QwiicFont _font = {5, 8};
+
+    void _markPage(uint8_t p, uint8_t col0, uint8_t col1) {
+        if (col0 < _dirty0[p]) _dirty0[p] = col0;
+        if (col1 > _dirty1[p]) _dirty1[p] = col1;
+    }
+
+    void _send(uint8_t p, uint8_t col0, uint8_t col1) {
+        bytesSent += 4; // page/column address commands
+        Wire.beginTransmission(0x3D);
+        for (uint8_t c = col0; c < col1; c++) {
+            _panel[p][c] = _buffer[p][c];
+            Wire.write(_buffer[p][c]);
+            bytesSent++;
+        }
+        Wire.endTransmission();
+    }
+};
+
+typedef QwiicOLEDNative<64, 48> QwiicMicroOLED;
+typedef QwiicOLEDNative<128, 32> QwiicNarrowOLED;
+typedef QwiicOLEDNative<128, 64> QwiicTransparentOLED;
+
+#endif // SPARKFUN_QWIIC_OLED_NATIVE_H
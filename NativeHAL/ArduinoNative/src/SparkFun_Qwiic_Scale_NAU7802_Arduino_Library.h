@@ -0,0 +1,69 @@
+#ifndef SPARKFUN_NAU7802_NATIVE_H
+#define SPARKFUN_NAU7802_NATIVE_H
+
+// SparkFun_Qwiic_Scale_NAU7802_Arduino_Library.h (native)
+// Simulated NAU7802 24-bit ADC. A new conversion becomes available every sample period
+// of virtual time; its value comes from `readingSource` when set, otherwise `reading`.
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#define NAU7802_SPS_10  0b000
+#define NAU7802_SPS_20  0b001
+#define NAU7802_SPS_40  0b010
+#define NAU7802_SPS_80  0b011
+#define NAU7802_SPS_320 0b111
+
+#define NAU7802_GAIN_1   0b000
+#define NAU7802_GAIN_128 0b111
+
+class NAU7802 {
+public:
+    bool begin(TwoWire& wire = Wire, bool reset = true) { (void)reset; _wire = &wire; _lastConversion = micros(); return true; }
+
+    bool setSampleRate(uint8_t rate) {
+        switch (rate) {
+            case NAU7802_SPS_20: _periodUs = 50000; break;
+            case NAU7802_SPS_40: _periodUs = 25000; break;
+            case NAU7802_SPS_80: _periodUs = 12500; break;
+            case NAU7802_SPS_320: _periodUs = 3125; break;
+            default: _periodUs = 100000; break;
+        }
+        return true;
+    }
+    bool setGain(uint8_t) { return true; }
+    bool calibrateAFE() { return true; }
+
+    bool available() {
+        _wire->requestFrom(0x2A, 1);
+        return (micros() - _lastConversion) >= _periodUs;
+    }
+
+    int32_t getReading() {
+        reads++;
+        _wire->requestFrom(0x2A, 3);
+        _lastConversion = micros();
+        return readingSource ? readingSource() : reading;
+    }
+
+    void calculateZeroOffset(uint8_t averageAmount = 8, unsigned long timeout_ms = 1000) {
+        (void)timeout_ms;
+        long total = 0;
+        for (uint8_t i = 0; i < averageAmount; i++) total += readingSource ? readingSource() : reading;
+        _zeroOffset = averageAmount ? (int32_t)(total / averageAmount) : 0;
+    }
+    int32_t getZeroOffset() const { return _zeroOffset; }
+    void setZeroOffset(int32_t offset) { _zeroOffset = offset; }
+
+    int32_t reading = 0;
+    int32_t (*readingSource)(void) = NULL;
+    unsigned long reads = 0;
+
+private:
+    TwoWire* _wire = &Wire;
+    unsigned long _periodUs = 100000;
+    unsigned long _lastConversion = 0;
+    int32_t _zeroOffset = 0;
+};
+
+#endif // SPARKFUN_NAU7802_NATIVE_H
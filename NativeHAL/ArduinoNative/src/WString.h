@@ -0,0 +1,109 @@
+#ifndef WSTRING_NATIVE_H
+#define WSTRING_NATIVE_H
+
+// WString.h (native)
+// Arduino String backed by std::string, plus the F() flash-string helpers.
+
+#include <string>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper*>(string_literal))
+
+class String {
+public:
+    String() {}
+    String(const char* s) : _s(s ? s : "") {}
+    String(const __FlashStringHelper* s) : _s(reinterpret_cast<const char*>(s)) {}
+    String(const std::string& s) : _s(s) {}
+    explicit String(char c) : _s(1, c) {}
+    explicit String(int n, unsigned char base = 10) { _fromLong(n, base); }
+    explicit String(unsigned int n, unsigned char base = 10) { _fromULong(n, base); }
+    explicit String(long n, unsigned char base = 10) { _fromLong(n, base); }
+    explicit String(unsigned long n, unsigned char base = 10) { _fromULong(n, base); }
+    explicit String(double n, unsigned char digits = 2) {
+        char buf[48];
+        snprintf(buf, sizeof(buf), "%.*f", digits, n);
+        _s = buf;
+    }
+
+    unsigned int length() const { return (unsigned int)_s.size(); }
+    const char* c_str() const { return _s.c_str(); }
+    bool reserve(unsigned int size) { _s.reserve(size); return true; }
+
+    char charAt(unsigned int i) const { return i < _s.size() ? _s[i] : 0; }
+    char operator[](unsigned int i) const { return charAt(i); }
+    void setCharAt(unsigned int i, char c) { if (i < _s.size()) _s[i] = c; }
+
+    String& operator=(const char* s) { _s = s ? s : ""; return *this; }
+    String& operator+=(const String& s) { _s += s._s; return *this; }
+    String& operator+=(const char* s) { if (s) _s += s; return *this; }
+    String& operator+=(char c) { _s += c; return *this; }
+    String& operator+=(int n) { return *this += String(n); }
+    String& operator+=(long n) { return *this += String(n); }
+    String& operator+=(unsigned long n) { return *this += String(n); }
+    String& operator+=(double n) { return *this += String(n); }
+    bool concat(const String& s) { *this += s; return true; }
+    bool concat(char c) { *this += c; return true; }
+
+    friend String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+    friend String operator+(const String& a, const char* b) { String r(a); r += b; return r; }
+    friend String operator+(const String& a, char b) { String r(a); r += b; return r; }
+
+    bool operator==(const String& o) const { return _s == o._s; }
+    bool operator==(const char* o) const { return o && _s == o; }
+    bool operator!=(const String& o) const { return _s != o._s; }
+    bool operator!=(const char* o) const { return !(*this == o); }
+    bool equals(const String& o) const { return *this == o; }
+    bool equalsIgnoreCase(const String& o) const { return strcasecmp(_s.c_str(), o._s.c_str()) == 0; }
+    bool startsWith(const String& p) const { return _s.compare(0, p._s.size(), p._s) == 0; }
+
+    int indexOf(char c, unsigned int from = 0) const {
+        size_t p = _s.find(c, from);
+        return p == std::string::npos ? -1 : (int)p;
+    }
+    int indexOf(const String& str, unsigned int from = 0) const {
+        size_t p = _s.find(str._s, from);
+        return p == std::string::npos ? -1 : (int)p;
+    }
+    String substring(unsigned int from) const { return from < _s.size() ? String(_s.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) { unsigned int t = from; from = to; to = t; }
+        if (from >= _s.size()) return String();
+        return String(_s.substr(from, to - from));
+    }
+
+    void trim() {
+        size_t b = 0;
+        while (b < _s.size() && isspace((unsigned char)_s[b])) b++;
+        size_t e = _s.size();
+        while (e > b && isspace((unsigned char)_s[e - 1])) e--;
+        _s = _s.substr(b, e - b);
+    }
+    void toUpperCase() { for (size_t i = 0; i < _s.size(); i++) _s[i] = (char)toupper((unsigned char)_s[i]); }
+    void toLowerCase() { for (size_t i = 0; i < _s.size(); i++) _s[i] = (char)tolower((unsigned char)_s[i]); }
+    long toInt() const { return atol(_s.c_str()); }
+    float toFloat() const { return (float)atof(_s.c_str()); }
+    double toDouble() const { return atof(_s.c_str()); }
+
+private:
+    std::string _s;
+
+    void _fromULong(unsigned long n, unsigned char base) {
+        char buf[72];
+        int i = (int)sizeof(buf) - 1;
+        buf[i] = '\0';
+        if (base < 2) base = 10;
+        do { int d = (int)(n % base); buf[--i] = (char)(d < 10 ? '0' + d : 'A' + d - 10); n /= base; } while (n && i > 0);
+        _s = &buf[i];
+    }
+    void _fromLong(long n, unsigned char base) {
+        if (n < 0 && base == 10) { _fromULong((unsigned long)(-n), base); _s.insert(0, 1, '-'); }
+        else _fromULong((unsigned long)n, base);
+    }
+};
+
+#endif // WSTRING_NATIVE_H
@@ -0,0 +1,33 @@
+#ifndef WIRE_NATIVE_H
+#define WIRE_NATIVE_H
+
+// Wire.h (native)
+// I2C bus stand-in. Nothing is attached; transactions and bytes are counted so the
+// bus load of a sketch can be measured.
+
+#include <Arduino.h>
+
+class TwoWire {
+public:
+    void begin() {}
+    void begin(int, int) {}
+    void setClock(uint32_t hz) { clock = hz; }
+    void beginTransmission(uint8_t) { transactions++; }
+    size_t write(uint8_t) { bytes++; return 1; }
+    size_t write(const uint8_t*, size_t n) { bytes += n; return n; }
+    uint8_t endTransmission(bool = true) { return 0; }
+    uint8_t requestFrom(uint8_t, uint8_t n, bool = true) { transactions++; bytes += n; _pending = n; return n; }
+    int available() { return _pending; }
+    int read() { if (_pending == 0) return -1; _pending--; return 0; }
+
+    uint32_t clock = 100000;
+    unsigned long transactions = 0;
+    unsigned long bytes = 0;
+
+private:
+    int _pending = 0;
+};
+
+extern TwoWire Wire;
+
+#endif // WIRE_NATIVE_H
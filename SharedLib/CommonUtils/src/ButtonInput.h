@@ -0,0 +1,163 @@
+#ifndef BUTTON_INPUT_H
+#define BUTTON_INPUT_H
+
+// ButtonInput.h
+// Debounced buttons with single, double and long press events, sampled from a timer.
+//
+// sample() is the producer and runs at a fixed period from a timer (a FreeRTOS task on
+// the ESP32, hal::every() on the host). It reads each pin once and debounces all the
+// buttons together with a 2-bit vertical counter: a button's debounced state flips only
+// after its raw level has differed for 4 consecutive samples (20 ms at 5 ms). The
+// gesture logic then turns debounced edges into events:
+//  - BUTTON_SINGLE: on press if the button has neither long nor double press enabled,
+//    otherwise on release once no second press followed within the double-press time
+//  - BUTTON_DOUBLE: second press released within the double-press time
+//  - BUTTON_LONG: held for the long-press time (reported while still held; the release
+//    that follows is not a click)
+//
+// Events go through a lock-free ring to read(), the consumer, called from loop(). Only
+// sample() touches the debounce and gesture state, so nothing is shared with loop()
+// except the ring.
+
+#include <Arduino.h>
+#include "SpscRing.h"
+
+#ifndef BUTTON_MAX
+#define BUTTON_MAX 8
+#endif
+
+#ifndef BUTTON_QUEUE_SIZE
+#define BUTTON_QUEUE_SIZE 16
+#endif
+
+enum ButtonEventType {
+    BUTTON_SINGLE = 1,
+    BUTTON_DOUBLE,
+    BUTTON_LONG
+};
+
+struct ButtonEvent {
+    uint8_t button;        // id returned by add()
+    uint8_t type;          // ButtonEventType
+    unsigned long at;      // millis() when recognised
+};
+
+class ButtonInput {
+    static_assert(BUTTON_MAX <= 8, "ButtonInput: the debounce masks are 8 bits wide");
+
+public:
+    ButtonInput()
+        : _count(0), _activeLow(0), _state(0), _ct0(0xFF), _ct1(0xFF), _dropped(0) {}
+
+    // Add a button; returns its id, or -1 when the table is full. doubleMs / longMs of
+    // 0 turn off double and long press detection for this button.
+    int8_t add(uint8_t pin, bool activeHigh, unsigned long doubleMs = 0, unsigned long longMs = 0) {
+        if (_count >= BUTTON_MAX) return -1;
+        Button& b = _buttons[_count];
+        b.pin = pin;
+        b.doubleMs = doubleMs;
+        b.longMs = longMs;
+        b.pressedAt = 0;
+        b.releasedAt = 0;
+        b.clickPending = false;
+        b.longSent = false;
+        b.secondPress = false;
+        if (!activeHigh) _activeLow |= 1 << _count;
+        return (int8_t)_count++;
+    }
+
+    // Producer: call at a fixed period from a timer
+    void sample() {
+        uint8_t raw = 0;
+        for (uint8_t i = 0; i < _count; i++) {
+            if (digitalRead(_buttons[i].pin)) raw |= 1 << i;
+        }
+        raw ^= _activeLow; // 1 = pressed
+
+        // Vertical counter: bits of changed buttons count down from 3; the state
+        // toggles when a counter wraps, and any sample matching the state resets it
+        uint8_t changed = raw ^ _state;
+        _ct0 = ~(_ct0 & changed);
+        _ct1 = _ct0 ^ (_ct1 & changed);
+        uint8_t toggle = changed & _ct0 & _ct1;
+        _state ^= toggle;
+
+        unsigned long now = millis();
+        for (uint8_t i = 0; i < _count; i++) {
+            Button& b = _buttons[i];
+            uint8_t bit = 1 << i;
+            if (toggle & bit) {
+                if (_state & bit) _pressed(i, b, now);
+                else _released(i, b, now);
+            } else if (_state & bit) {
+                if (b.longMs && !b.longSent && now - b.pressedAt >= b.longMs) {
+                    b.longSent = true;
+                    b.clickPending = false;
+                    _emit(i, BUTTON_LONG, now);
+                }
+            } else if (b.clickPending && now - b.releasedAt >= b.doubleMs) {
+                b.clickPending = false;
+                _emit(i, BUTTON_SINGLE, now);
+            }
+        }
+    }
+
+    // Consumer: next event, oldest first
+    bool read(ButtonEvent& e) { return _events.pop(e); }
+
+    // Debounced state of button `id` (as of the last sample)
+    bool isPressed(uint8_t id) const { return (_state >> id) & 1; }
+    // Events lost because loop() did not read them in time
+    unsigned long dropped() const { return _dropped; }
+
+private:
+    struct Button {
+        uint8_t pin;
+        unsigned long doubleMs;
+        unsigned long longMs;
+        unsigned long pressedAt;
+        unsigned long releasedAt;
+        bool clickPending;  // released once, waiting for a possible second press
+        bool longSent;
+        bool secondPress;   // this press followed a pending click
+    };
+
+    Button _buttons[BUTTON_MAX];
+    uint8_t _count;
+    uint8_t _activeLow;
+    uint8_t _state;         // debounced, 1 = pressed
+    uint8_t _ct0, _ct1;     // vertical counter bits, one per button
+    unsigned long _dropped;
+    SpscRing<ButtonEvent, BUTTON_QUEUE_SIZE> _events;
+
+    void _pressed(uint8_t id, Button& b, unsigned long now) {
+        b.pressedAt = now;
+        b.longSent = false;
+        b.secondPress = b.clickPending;
+        b.clickPending = false;
+        if (!b.longMs && !b.doubleMs) _emit(id, BUTTON_SINGLE, now);
+    }
+
+    void _released(uint8_t id, Button& b, unsigned long now) {
+        b.releasedAt = now;
+        if (b.longSent || (!b.longMs && !b.doubleMs)) return;
+        if (b.secondPress) {
+            b.secondPress = false;
+            _emit(id, BUTTON_DOUBLE, now);
+        } else if (b.doubleMs) {
+            b.clickPending = true;
+        } else {
+            _emit(id, BUTTON_SINGLE, now);
+        }
+    }
+
+    void _emit(uint8_t id, uint8_t type, unsigned long now) {
+        ButtonEvent e;
+        e.button = id;
+        e.type = type;
+        e.at = now;
+        if (!_events.push(e)) _dropped++;
+    }
+};
+
+#endif // BUTTON_INPUT_H
@@ -0,0 +1,54 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+// SpscRing.h
+// Lock-free ring buffer for one producer and one consumer, e.g. an ISR or sensor task
+// handing items to loop().
+//
+// The producer only writes _head and the consumer only writes _tail, so neither side
+// needs to disable interrupts. Each index is published with a memory barrier after the
+// slot it covers has been written or read, which also orders the two cores of the
+// ESP32. SIZE must be a power of two; the ring holds SIZE - 1 items.
+
+#include <Arduino.h>
+
+template <class T, uint16_t SIZE>
+class SpscRing {
+    static_assert(SIZE >= 2 && (SIZE & (SIZE - 1)) == 0, "SpscRing: SIZE must be a power of two");
+
+public:
+    SpscRing() : _head(0), _tail(0) {}
+
+    // Producer side. Returns false (and drops the item) when the ring is full.
+    bool push(const T& item) {
+        uint16_t head = _head;
+        uint16_t next = (head + 1) & (SIZE - 1);
+        if (next == _tail) return false;
+        _items[head] = item;
+        __sync_synchronize();
+        _head = next;
+        return true;
+    }
+
+    // Consumer side. Returns false when the ring is empty.
+    bool pop(T& item) {
+        uint16_t tail = _tail;
+        if (tail == _head) return false;
+        __sync_synchronize();
+        item = _items[tail];
+        __sync_synchronize();
+        _tail = (tail + 1) & (SIZE - 1);
+        return true;
+    }
+
+    uint16_t count() const { return (_head - _tail) & (SIZE - 1); }
+    bool empty() const { return _head == _tail; }
+    static uint16_t capacity() { return SIZE - 1; }
+
+private:
+    T _items[SIZE];
+    volatile uint16_t _head; // next slot to write (producer)
+    volatile uint16_t _tail; // next slot to read (consumer)
+};
+
+#endif // SPSC_RING_H
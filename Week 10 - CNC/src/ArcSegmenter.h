@@ -0,0 +1,163 @@
+#ifndef ARC_SEGMENTER_H
+#define ARC_SEGMENTER_H
+
+// ArcSegmenter.h
+// Splits G2/G3 arcs into short linear segments on the controller so the host can send
+// one arc line instead of thousands of tiny G1 moves.
+// The segment count is chosen so that no chord deviates from the true arc by more than
+// the configured tolerance. Successive segment end points are produced by rotating the
+// radius vector with a small-angle rotation matrix (third-order Taylor terms), and every
+// ARC_CORRECTION_INTERVAL segments the vector is recomputed exactly with sin/cos to
+// cancel the accumulated rounding error.
+//
+// The segmenter is a generator: begin() sets up the arc, next() returns one segment end
+// point at a time so the caller can feed the planner only while it has room.
+// All distances are in steps.
+
+#include <Arduino.h>
+#include <math.h>
+
+#ifndef ARC_CORRECTION_INTERVAL
+#define ARC_CORRECTION_INTERVAL 12 // incremental rotations between exact sin/cos corrections
+#endif
+
+#define ARC_ANGULAR_EPSILON 5e-7f // arcs shorter than this (radians) are full circles
+
+class ArcSegmenter {
+public:
+    ArcSegmenter()
+        : _tolerance(0.5f), _segments(0), _index(0), _sinceCorrection(0),
+          _thetaPerSegment(0.0f), _cosT(1.0f), _sinT(0.0f)
+    {
+        _center[0] = 0.0f; _center[1] = 0.0f;
+        _radius[0] = 0.0f; _radius[1] = 0.0f;
+        _offset[0] = 0.0f; _offset[1] = 0.0f;
+        _target[0] = 0; _target[1] = 0;
+    }
+
+    // Maximum distance between a chord and the arc (steps).
+    void setTolerance(float steps) { _tolerance = fabs(steps); }
+    float getTolerance() const { return _tolerance; }
+
+    // Whether (x1, y1) lies on the circle through (x0, y0) around (x0 + i, y0 + j), within
+    // rounding. begin() accepts exactly these arcs.
+    static bool onCircle(long x0, long y0, long x1, long y1, float i, float j) {
+        float radius = sqrt(i * i + j * j);
+        if (radius <= 0.0f) return false;
+        float rt0 = x1 - (x0 + i);
+        float rt1 = y1 - (y0 + j);
+        float error = fabs(sqrt(rt0 * rt0 + rt1 * rt1) - radius);
+        return !(error > 2.0f && error > 0.001f * radius);
+    }
+
+    // Center offset (i, j) of the arc of radius r from (x0, y0) to (x1, y1) (G2/G3 R form).
+    // A negative radius selects the arc longer than a half circle. Returns false if the
+    // end point is out of reach.
+    static bool centerFromRadius(long x0, long y0, long x1, long y1, float r, bool clockwise,
+                                 float& i, float& j) {
+        float dx = x1 - x0;
+        float dy = y1 - y0;
+        float chordSqr = dx * dx + dy * dy;
+        if (chordSqr <= 0.0f) return false; // full circles need I/J
+        float hSqr = 4.0f * r * r - chordSqr;
+        if (hSqr < 0.0f) {
+            // Allow for rounding when the chord is a diameter
+            if (-hSqr > 0.002f * 4.0f * r * r) return false;
+            hSqr = 0.0f;
+        }
+        // Distance from the chord midpoint to the center, over half the chord
+        float h = -sqrt(hSqr) / sqrt(chordSqr);
+        if (!clockwise) h = -h;
+        if (r < 0.0f) h = -h;
+        i = 0.5f * (dx - dy * h);
+        j = 0.5f * (dy + dx * h);
+        return true;
+    }
+
+    // Start an arc from (x0, y0) to (x1, y1) around the center (x0 + i, y0 + j).
+    // Returns false if the end point does not lie on the circle.
+    bool begin(long x0, long y0, long x1, long y1, float i, float j, bool clockwise) {
+        _segments = 0;
+        _index = 0;
+        if (!onCircle(x0, y0, x1, y1, i, j)) return false;
+        float radius = sqrt(i * i + j * j);
+
+        _center[0] = x0 + i;
+        _center[1] = y0 + j;
+        _offset[0] = -i; // radius vector from the center to the start point
+        _offset[1] = -j;
+        float rt0 = x1 - _center[0]; // radius vector from the center to the target
+        float rt1 = y1 - _center[1];
+
+        float angularTravel = atan2(_offset[0] * rt1 - _offset[1] * rt0, _offset[0] * rt0 + _offset[1] * rt1);
+        if (clockwise) {
+            if (angularTravel >= -ARC_ANGULAR_EPSILON) angularTravel -= 2.0f * (float)PI;
+        } else {
+            if (angularTravel <= ARC_ANGULAR_EPSILON) angularTravel += 2.0f * (float)PI;
+        }
+
+        // Longest chord with sagitta <= tolerance is 2 * sqrt(tol * (2r - tol))
+        float tol = _tolerance < radius ? _tolerance : radius;
+        float segmentLength = 2.0f * sqrt(tol * (2.0f * radius - tol));
+        unsigned long segments = 1;
+        if (segmentLength > 0.0f) segments = (unsigned long)ceil(fabs(angularTravel) * radius / segmentLength);
+        if (segments < 1) segments = 1;
+
+        _segments = segments;
+        _thetaPerSegment = angularTravel / segments;
+        // Small-angle rotation: cos ~ 1 - t^2/2, sin ~ t - t^3/6
+        _cosT = 1.0f - 0.5f * _thetaPerSegment * _thetaPerSegment;
+        _sinT = _thetaPerSegment * (1.0f - _thetaPerSegment * _thetaPerSegment / 6.0f);
+        _radius[0] = _offset[0];
+        _radius[1] = _offset[1];
+        _sinceCorrection = 0;
+        _target[0] = x1;
+        _target[1] = y1;
+        return true;
+    }
+
+    bool isActive() const { return _index < _segments; }
+    unsigned long segmentCount() const { return _segments; }
+
+    // End point of the next segment. The last segment ends exactly on the target.
+    // Returns false when the arc is finished.
+    bool next(long& x, long& y) {
+        if (_index >= _segments) return false;
+        _index++;
+        if (_index == _segments) {
+            x = _target[0];
+            y = _target[1];
+            return true;
+        }
+        if (_sinceCorrection < ARC_CORRECTION_INTERVAL) {
+            float r0 = _radius[0] * _cosT - _radius[1] * _sinT;
+            _radius[1] = _radius[0] * _sinT + _radius[1] * _cosT;
+            _radius[0] = r0;
+            _sinceCorrection++;
+        } else {
+            float theta = _index * _thetaPerSegment;
+            float c = cos(theta);
+            float s = sin(theta);
+            _radius[0] = _offset[0] * c - _offset[1] * s;
+            _radius[1] = _offset[0] * s + _offset[1] * c;
+            _sinceCorrection = 0;
+        }
+        x = lround(_center[0] + _radius[0]);
+        y = lround(_center[1] + _radius[1]);
+        return true;
+    }
+
+private:
+    float _tolerance;
+    float _center[2];
+    float _offset[2];   // center -> start
+    float _radius[2];   // center -> current point
+    long _target[2];
+    unsigned long _segments;
+    unsigned long _index;
+    uint8_t _sinceCorrection;
+    float _thetaPerSegment;
+    float _cosT, _sinT;
+};
+
+#endif // ARC_SEGMENTER_H
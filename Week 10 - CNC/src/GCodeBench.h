@@ -0,0 +1,252 @@
+#ifndef GCODE_BENCH_H
+#define GCODE_BENCH_H
+
+// GCodeBench.h
+// Parser throughput benchmark. GCodeCorpus generates a deterministic stream of typical
+// CAM output (long G1 polylines with X/Y/F words, rapids, comments, exponents, spindle
+// commands) one line at a time, so the same corpus can be parsed on the host
+// (GCodeBenchHost.cpp, env:native_bench) and on the controller (env:uno_bench) without
+// ever holding it in memory.
+//
+// On-target: build with -D GCODE_BENCH=1 and setup() runs GCodeBench::run() over serial
+// instead of starting the controller. Cycle counts come from Timer1 at clk/1 on AVR,
+// from the CPU cycle counter on ESP32, and from micros() * F_CPU elsewhere.
+
+#include <Arduino.h>
+#include "GCodeParser.h"
+
+#ifndef GCODE_BENCH_LINES
+#define GCODE_BENCH_LINES 2000UL // lines parsed by the on-target run
+#endif
+
+#define GCODE_BENCH_LINE_MAX 96
+#define GCODE_BENCH_BINS 64            // latency histogram bins for the percentile estimate
+#define GCODE_BENCH_BIN_CYCLES 256UL   // cycles per histogram bin
+
+class GCodeCorpus {
+public:
+    GCodeCorpus(uint32_t seed = 12345) : _state(seed), _x(200000), _y(200000), _lineNumber(0) {}
+
+    // Write the next line (no newline, NUL terminated) into buf; returns its length.
+    size_t nextLine(char* buf, size_t cap) {
+        _out = buf;
+        _cap = cap;
+        _len = 0;
+        _lineNumber++;
+
+        uint32_t kind = _rand() % 100;
+        if (kind < 2) {
+            _put("(contour ");
+            _putLong((long)_lineNumber);
+            _put(" finishing pass)");
+        } else if (kind < 4) {
+            _put("G0 X");
+            _walk(100);
+            _putFixed(_x, 3);
+            _put(" Y");
+            _putFixed(_y, 3);
+        } else if (kind < 5) {
+            _put("M3 S");
+            _putLong((long)(_rand() % 256));
+        } else if (kind < 10) {
+            // Exponent notation, as emitted by some post-processors
+            _put("G1 X");
+            _walk(4);
+            _putExp(_x);
+            _put(" Y");
+            _putExp(_y);
+        } else {
+            // Polyline vertex; a feed word on roughly every fourth line, a trailing comment sometimes
+            _put("G1 X");
+            _walk(4);
+            _putFixed(_x, 3);
+            _put(" Y");
+            _putFixed(_y, 3);
+            if ((_rand() & 3) == 0) {
+                _put(" F");
+                _putLong((long)(600 + (_rand() % 30) * 100));
+            }
+            if ((_rand() % 10) == 0) _put(" ; seg");
+        }
+        _out[_len] = '\0';
+        return _len;
+    }
+
+private:
+    uint32_t _state;
+    long _x, _y; // thousandths of a unit
+    uint32_t _lineNumber;
+    char* _out;
+    size_t _cap;
+    size_t _len;
+
+    uint32_t _rand() {
+        _state = _state * 1664525UL + 1013904223UL;
+        return _state >> 8;
+    }
+
+    // Random walk of up to +/-step units, kept within a 0..400 unit work area
+    void _walk(long step) {
+        long range = step * 2000 + 1;
+        _x += (long)(_rand() % (uint32_t)range) - step * 1000;
+        _y += (long)(_rand() % (uint32_t)range) - step * 1000;
+        _x = constrain(_x, 0L, 400000L);
+        _y = constrain(_y, 0L, 400000L);
+    }
+
+    void _putChar(char c) {
+        if (_len + 1 < _cap) _out[_len++] = c;
+    }
+    void _put(const char* s) {
+        while (*s) _putChar(*s++);
+    }
+    void _putLong(long v) {
+        char digits[12];
+        uint8_t n = 0;
+        if (v < 0) { _putChar('-'); v = -v; }
+        do { digits[n++] = (char)('0' + v % 10); v /= 10; } while (v > 0);
+        while (n > 0) _putChar(digits[--n]);
+    }
+    // value is in units of 10^-decimals
+    void _putFixed(long value, uint8_t decimals) {
+        long scale = 1;
+        for (uint8_t i = 0; i < decimals; i++) scale *= 10;
+        if (value < 0) { _putChar('-'); value = -value; }
+        _putLong(value / scale);
+        _putChar('.');
+        long frac = value % scale;
+        for (long s = scale / 10; s > 0; s /= 10) {
+            _putChar((char)('0' + (frac / s) % 10));
+        }
+    }
+    // thousandths printed as d.dddde+N
+    void _putExp(long value) {
+        if (value == 0) { _put("0.0e0"); return; }
+        int e = -3;
+        long m = value;
+        while (m >= 100000L) { m /= 10; e++; }
+        int digits = 0;
+        for (long t = m; t >= 10; t /= 10) digits++;
+        _putFixed(m, (uint8_t)digits);
+        _putChar('e');
+        _putLong(e + digits);
+    }
+};
+
+class GCodeBench {
+public:
+    // Parse `lines` corpus lines and print throughput and per-line cycle statistics.
+    static void run(Print& out, unsigned long lines = GCODE_BENCH_LINES) {
+        GCodeCorpus corpus;
+        char line[GCODE_BENCH_LINE_MAX];
+        uint16_t histogram[GCODE_BENCH_BINS];
+        memset(histogram, 0, sizeof(histogram));
+
+        unsigned long bytes = 0;
+        unsigned long errors = 0;
+        unsigned long long totalCycles = 0;
+        uint32_t maxCycles = 0;
+        volatile long sink = 0; // keeps the parse results live
+
+        _beginCycles();
+        unsigned long startMicros = micros();
+        for (unsigned long i = 0; i < lines; i++) {
+            size_t len = corpus.nextLine(line, sizeof(line));
+            bytes += len + 1;
+
+            uint32_t t0 = _cycles();
+            GCodeParser::Command cmd = GCodeParser::parseLine(line, len);
+            uint32_t dt = _cycles() - t0;
+
+            if (!cmd.valid && cmd.error != GCodeParser::ERR_EMPTY_LINE) errors++;
+            sink = sink + cmd.x.whole + cmd.x.micro;
+            totalCycles += dt;
+            if (dt > maxCycles) maxCycles = dt;
+            uint32_t bin = dt / GCODE_BENCH_BIN_CYCLES;
+            if (bin >= GCODE_BENCH_BINS) bin = GCODE_BENCH_BINS - 1;
+            histogram[bin]++;
+        }
+        unsigned long elapsed = micros() - startMicros; // includes corpus generation
+        _endCycles();
+
+        // 99th percentile: upper edge of the bin where the cumulative count crosses 99%
+        unsigned long target = lines - lines / 100;
+        unsigned long cumulative = 0;
+        uint32_t p99 = 0;
+        for (uint8_t b = 0; b < GCODE_BENCH_BINS; b++) {
+            cumulative += histogram[b];
+            if (cumulative >= target) { p99 = (b + 1) * GCODE_BENCH_BIN_CYCLES; break; }
+        }
+
+        float parseSeconds = (float)totalCycles / (float)cyclesPerSecond();
+        out.println(F("GCODE_BENCH"));
+        out.print(F("lines: ")); out.println(lines);
+        out.print(F("bytes: ")); out.println(bytes);
+        out.print(F("errors: ")); out.println(errors);
+        out.print(F("wall us (incl. generation): ")); out.println(elapsed);
+        out.print(F("cycles/line mean: ")); out.println((unsigned long)(totalCycles / lines));
+        out.print(F("cycles/line p99 <= ")); out.println((unsigned long)p99);
+        out.print(F("cycles/line max: ")); out.println((unsigned long)maxCycles);
+        out.print(F("lines/s: ")); out.println((unsigned long)(lines / parseSeconds));
+        out.print(F("bytes/s: ")); out.println((unsigned long)(bytes / parseSeconds));
+        out.println(F("allocations/line: 0 (parser has no heap path)"));
+    }
+
+    static unsigned long cyclesPerSecond() {
+#if defined(F_CPU)
+        return F_CPU;
+#elif defined(ARDUINO_ARCH_ESP32)
+        return (unsigned long)getCpuFrequencyMhz() * 1000000UL;
+#else
+        return 1000000UL; // micros() fallback
+#endif
+    }
+
+private:
+#if defined(__AVR__)
+    static volatile uint16_t& _overflows() {
+        static volatile uint16_t overflows = 0;
+        return overflows;
+    }
+#endif
+
+    // Timer1 free-running at clk/1. The step engine is not started in benchmark builds,
+    // so the timer is free; overflows are folded in by polling TOV1 on every read.
+    static void _beginCycles() {
+#if defined(__AVR__)
+        noInterrupts();
+        TCCR1A = 0;
+        TCCR1B = (1 << CS10);
+        TIMSK1 = 0;
+        TCNT1 = 0;
+        TIFR1 = (1 << TOV1);
+        _overflows() = 0;
+        interrupts();
+#endif
+    }
+    static void _endCycles() {
+#if defined(__AVR__)
+        TCCR1B = 0;
+#endif
+    }
+
+    static uint32_t _cycles() {
+#if defined(__AVR__)
+        uint16_t t = TCNT1;
+        if (TIFR1 & (1 << TOV1)) {
+            TIFR1 = (1 << TOV1);
+            _overflows()++;
+            t = TCNT1;
+        }
+        return ((uint32_t)_overflows() << 16) | t;
+#elif defined(ARDUINO_ARCH_ESP32)
+        return ESP.getCycleCount();
+#elif defined(F_CPU)
+        return micros() * (F_CPU / 1000000UL);
+#else
+        return micros();
+#endif
+    }
+};
+
+#endif // GCODE_BENCH_H
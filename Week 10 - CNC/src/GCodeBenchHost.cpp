@@ -0,0 +1,123 @@
+// GCodeBenchHost.cpp
+// Host-side parser benchmark (env:native_bench). Generates a multi-megabyte corpus with
+// GCodeCorpus, then parses it line by line and reports lines/s, bytes/s, heap
+// allocations per line and per-line latency percentiles.
+//
+//   pio run -e native_bench && .pio/build/native_bench/program [megabytes]
+//
+// The whole file is compiled out unless GCODE_BENCH_HOST is defined, so the board
+// environments are unaffected.
+
+#if defined(GCODE_BENCH_HOST)
+
+#include <Arduino.h>
+#include "GCodeParser.h"
+#include "GCodeBench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Count every heap allocation made while the parser runs
+static unsigned long long allocationCount = 0;
+
+void* operator new(size_t size) {
+    allocationCount++;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+static inline uint64_t readCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// The HAL's main() is disabled for this environment; these satisfy its declarations.
+void setup() {}
+void loop() {}
+
+int main(int argc, char** argv) {
+    double megabytes = (argc > 1) ? atof(argv[1]) : 8.0;
+    size_t targetBytes = (size_t)(megabytes * 1024.0 * 1024.0);
+
+    // Build the corpus up front so generation is not part of the timing
+    std::vector<char> text;
+    std::vector<uint32_t> offsets;
+    text.reserve(targetBytes + GCODE_BENCH_LINE_MAX);
+    GCodeCorpus corpus;
+    char line[GCODE_BENCH_LINE_MAX];
+    while (text.size() < targetBytes) {
+        size_t len = corpus.nextLine(line, sizeof(line));
+        offsets.push_back((uint32_t)text.size());
+        text.insert(text.end(), line, line + len);
+        text.push_back('\n');
+    }
+    offsets.push_back((uint32_t)text.size());
+    size_t lines = offsets.size() - 1;
+
+    std::vector<uint32_t> latencyNs(lines);
+    std::vector<uint32_t> latencyCycles(lines);
+    unsigned long errors = 0;
+    volatile long sink = 0;
+
+    unsigned long long allocationsBefore = allocationCount;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lines; i++) {
+        const char* p = &text[offsets[i]];
+        size_t len = offsets[i + 1] - offsets[i] - 1; // without the newline
+        auto t0 = std::chrono::steady_clock::now();
+        uint64_t c0 = readCycles();
+        GCodeParser::Command cmd = GCodeParser::parseLine(p, len);
+        uint64_t c1 = readCycles();
+        auto t1 = std::chrono::steady_clock::now();
+        latencyNs[i] = (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+        latencyCycles[i] = (uint32_t)(c1 - c0);
+        if (!cmd.valid && cmd.error != GCodeParser::ERR_EMPTY_LINE) errors++;
+        sink = sink + cmd.x.whole + cmd.x.micro;
+    }
+    auto stop = std::chrono::steady_clock::now();
+    unsigned long long allocations = allocationCount - allocationsBefore;
+
+    // Throughput from a second, untimed-per-line pass so clock reads do not inflate it
+    auto bulkStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lines; i++) {
+        GCodeParser::Command cmd = GCodeParser::parseLine(&text[offsets[i]], offsets[i + 1] - offsets[i] - 1);
+        sink = sink + cmd.x.whole + cmd.x.micro;
+    }
+    auto bulkStop = std::chrono::steady_clock::now();
+    double bulkSeconds = std::chrono::duration<double>(bulkStop - bulkStart).count();
+    double timedSeconds = std::chrono::duration<double>(stop - start).count();
+
+    std::sort(latencyNs.begin(), latencyNs.end());
+    std::sort(latencyCycles.begin(), latencyCycles.end());
+    size_t p50 = lines / 2;
+    size_t p99 = lines - 1 - lines / 100;
+
+    printf("GCODE_BENCH host\n");
+    printf("corpus: %zu lines, %zu bytes (%.1f MB)\n", lines, text.size(), text.size() / 1048576.0);
+    printf("errors: %lu\n", errors);
+    printf("lines/s: %.0f\n", lines / bulkSeconds);
+    printf("bytes/s: %.0f (%.1f MB/s)\n", text.size() / bulkSeconds, text.size() / bulkSeconds / 1048576.0);
+    printf("allocations/line: %.3f\n", (double)allocations / lines);
+    printf("latency ns p50/p99/max: %u / %u / %u\n", latencyNs[p50], latencyNs[p99], latencyNs[lines - 1]);
+#if defined(__x86_64__) || defined(__i386__)
+    printf("cycles/line (TSC) p50/p99/max: %u / %u / %u\n", latencyCycles[p50], latencyCycles[p99], latencyCycles[lines - 1]);
+#endif
+    printf("timed pass: %.3f s (includes two clock reads per line)\n", timedSeconds);
+    return 0;
+}
+
+#endif // GCODE_BENCH_HOST
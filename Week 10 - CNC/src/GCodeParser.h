@@ -2,137 +2,194 @@
 #define GCODE_PARSER_H
 
 // GCodeParser.h
-// Simple single-line G-code parser supporting: M3 (with S 0-255), G28, G0, G1 (with optional F).
+// Simple single-line G-code parser supporting: M3 (with S 0-255), G28, G0, G1 (with optional F),
+// G2/G3 arcs (center offset I/J or radius R, optional F).
 // Supports X and Y axes. Intended to be used with serial input lines.
+//
+// The parser works in place over a char span and never touches the heap: comments are
+// skipped while scanning, numbers are converted straight from the line text into fixed
+// point micro-units (see Fixed) and errors are reported as codes whose messages live in
+// flash (see errorMessage()).
 
 #include <Arduino.h>
 #include <ctype.h>
 #include <stdlib.h>
-#include <errno.h>
+#include <string.h>
 #include <limits.h>
 
+#define FIXED_DECIMALS 6
+#define FIXED_ONE 1000000UL                 // micro-units per unit
+#define FIXED_WHOLE_MAX 2147483647UL         // largest magnitude of the integer part
+#define FIXED_MAX_STEPS_PER_UNIT (LONG_MAX / 1000000L) // micro * stepsPerUnit fits in a long (2147 on AVR)
+
 class GCodeParser {
 public:
     enum Type {
         TYPE_UNKNOWN = 0,
         TYPE_G0,
         TYPE_G1,
+        TYPE_G2,
+        TYPE_G3,
         TYPE_G28,
         TYPE_M3
     };
 
+    enum Error {
+        ERR_NONE = 0,
+        ERR_EMPTY_LINE,
+        ERR_UNEXPECTED_CHAR,
+        ERR_G_NO_NUMBER,
+        ERR_M_NO_NUMBER,
+        ERR_X_NO_VALUE,
+        ERR_Y_NO_VALUE,
+        ERR_F_NO_VALUE,
+        ERR_S_NO_VALUE,
+        ERR_I_NO_VALUE,
+        ERR_J_NO_VALUE,
+        ERR_R_NO_VALUE,
+        ERR_ARC_CENTER,
+        ERR_ARC_END_POINT,  // reported by the controller, which knows where the arc starts
+        ERR_NEGATIVE_FEED,
+        ERR_S_OUT_OF_RANGE,
+        ERR_INVALID_NUMBER,
+        ERR_NUMBER_OUT_OF_RANGE,
+        ERR_UNSUPPORTED_G,
+        ERR_NO_COMMAND
+    };
+
+    // Decimal value held as whole + micro / 1000000. Both parts carry the sign of the
+    // value, so -1.25 is {-1, -250000}. Parsing and conversion to steps stay in 32-bit
+    // integer arithmetic (no software float on AVR) and keep full precision over the
+    // whole int32 range.
+    struct Fixed {
+        int32_t whole = 0;
+        int32_t micro = 0;
+    };
+
     struct Command {
         bool valid = false;
         Type type = TYPE_UNKNOWN;
         // Axis/parameters
         bool hasX = false;
-        double x = 0.0;
+        Fixed x;
         bool hasY = false;
-        double y = 0.0;
+        Fixed y;
         bool hasF = false;
-        double f = 0.0;
+        Fixed f;
+        // Arc center offset from the start point (G2/G3 I/J) or radius (R)
+        bool hasI = false;
+        Fixed i;
+        bool hasJ = false;
+        Fixed j;
+        bool hasR = false;
+        Fixed r;
         bool hasS = false;
         int s = 0; // 0..255 for M3
-        String error; // non-empty when valid==false
+        Error error = ERR_NONE; // set when valid==false
     };
 
-    // Parse a single line of gcode. Trims comments (starting with ';' or '(').
-    // Returns a Command struct describing the parsed command or an error.
-    static Command parseLine(const String& rawLine) {
+    // Parse a single line of gcode held in line[0..len). Skips comments (starting with ';' or '(').
+    // Returns a Command struct describing the parsed command or an error. Allocates nothing.
+    static Command parseLine(const char* line, size_t len) {
         Command cmd;
-        String line = stripComments(rawLine);
-        line.trim();
-        if (line.length() == 0) {
-            cmd.valid = false;
-            cmd.error = F("Empty line");
-            return cmd;
-        }
+        if (line == NULL) len = 0;
+        const char* p = line;
+        const char* end = line + len;
 
         // Tokenize: sequence of letter followed by optional signed/float number.
         // We'll collect numeric values for letters of interest.
         int gNumber = -1;
         int mNumber = -1;
+        bool sawWord = false;
 
-        for (uint16_t i = 0; i < line.length(); ) {
-            // skip whitespace
-            char ci = line.charAt(i);
-            if (isspace((unsigned char)ci)) { ++i; continue; }
-            char letter = toupper((unsigned char)ci);
-            if (!isalpha((unsigned char)letter)) {
-                cmd.valid = false;
-                cmd.error = F("Unexpected character in input");
-                return cmd;
-            }
-            ++i;
-            // collect number start
-            uint16_t numStart = i;
-            // allow sign, digits, decimal point, exponent
-            if (i < line.length() && (line.charAt(i) == '+' || line.charAt(i) == '-')) ++i;
-            bool sawDigits = false;
-            while (i < line.length() && isdigit((unsigned char)line.charAt(i))) { ++i; sawDigits = true; }
-            if (i < line.length() && line.charAt(i) == '.') {
-                ++i;
-                while (i < line.length() && isdigit((unsigned char)line.charAt(i))) { ++i; sawDigits = true; }
-            }
-            if (i < line.length() && (line.charAt(i) == 'e' || line.charAt(i) == 'E')) {
-                uint16_t epos = i;
-                ++i;
-                if (i < line.length() && (line.charAt(i) == '+' || line.charAt(i) == '-')) ++i;
-                bool expDigits = false;
-                while (i < line.length() && isdigit((unsigned char)line.charAt(i))) { ++i; expDigits = true; }
-                if (!expDigits) {
-                    // malformed exponent: rollback to before 'e' (treat as end of token)
-                    i = epos;
-                }
+        while (p < end) {
+            char ci = *p;
+            if (ci == ';') break; // rest of line is a comment
+            if (ci == '(') {
+                // parenthesis comment: skip up to and including ')'
+                while (p < end && *p != ')') ++p;
+                if (p < end) ++p;
+                continue;
             }
+            if (ci == ')' || isspace((unsigned char)ci)) { ++p; continue; }
 
-            String numberText;
-            if (numStart < i) numberText = line.substring(numStart, i);
+            sawWord = true;
+            char letter = toupper((unsigned char)ci);
+            if (!isalpha((unsigned char)letter)) return fail(cmd, ERR_UNEXPECTED_CHAR);
+            ++p;
+            const char* numStart = p;
+            p = scanNumber(p, end);
+            bool hasNumber = numStart < p;
 
             // dispatch
-            if (letter == 'G') {
-                if (numberText.length() == 0) { cmd.valid = false; cmd.error = F("G with no number"); return cmd; }
-                int val = (int)parseDouble(numberText, cmd.error);
-                if (cmd.error.length() > 0) { cmd.valid = false; return cmd; }
-                gNumber = val;
-            } else if (letter == 'M') {
-                if (numberText.length() == 0) { cmd.valid = false; cmd.error = F("M with no number"); return cmd; }
-                int val = (int)parseDouble(numberText, cmd.error);
-                if (cmd.error.length() > 0) { cmd.valid = false; return cmd; }
-                mNumber = val;
-            } else if (letter == 'X') {
-                if (numberText.length() == 0) { cmd.valid = false; cmd.error = F("X with no value"); return cmd; }
-                double v = parseDouble(numberText, cmd.error);
-                if (cmd.error.length() > 0) { cmd.valid = false; return cmd; }
-                cmd.hasX = true;
-                cmd.x = v;
-            } else if (letter == 'Y') {
-                if (numberText.length() == 0) { cmd.valid = false; cmd.error = F("Y with no value"); return cmd; }
-                double v = parseDouble(numberText, cmd.error);
-                if (cmd.error.length() > 0) { cmd.valid = false; return cmd; }
-                cmd.hasY = true;
-                cmd.y = v;
-            } else if (letter == 'F') {
-                if (numberText.length() == 0) { cmd.valid = false; cmd.error = F("F with no value"); return cmd; }
-                double v = parseDouble(numberText, cmd.error);
-                if (cmd.error.length() > 0) { cmd.valid = false; return cmd; }
-                if (v < 0.0) { cmd.valid = false; cmd.error = F("Feed rate F must be non-negative"); return cmd; }
-                cmd.hasF = true;
-                cmd.f = v;
-            } else if (letter == 'S') {
-                if (numberText.length() == 0) { cmd.valid = false; cmd.error = F("S with no value"); return cmd; }
-                double v = parseDouble(numberText, cmd.error);
-                if (cmd.error.length() > 0) { cmd.valid = false; return cmd; }
-                int iv = (int)v;
-                if (iv < 0 || iv > 255) { cmd.valid = false; cmd.error = F("S value out of range 0-255"); return cmd; }
-                cmd.hasS = true;
-                cmd.s = iv;
-            } else {
-                // ignore other letters gracefully (could be comments, tool number, etc.)
-                // but if they had a number and we don't recognize it, just skip.
+            Fixed v;
+            Error err = ERR_NONE;
+            switch (letter) {
+                case 'G':
+                    if (!hasNumber) return fail(cmd, ERR_G_NO_NUMBER);
+                    if ((err = parseNumber(numStart, p, v)) != ERR_NONE) return fail(cmd, err);
+                    gNumber = (int)v.whole;
+                    break;
+                case 'M':
+                    if (!hasNumber) return fail(cmd, ERR_M_NO_NUMBER);
+                    if ((err = parseNumber(numStart, p, v)) != ERR_NONE) return fail(cmd, err);
+                    mNumber = (int)v.whole;
+                    break;
+                case 'X':
+                    if (!hasNumber) return fail(cmd, ERR_X_NO_VALUE);
+                    if ((err = parseNumber(numStart, p, v)) != ERR_NONE) return fail(cmd, err);
+                    cmd.hasX = true;
+                    cmd.x = v;
+                    break;
+                case 'Y':
+                    if (!hasNumber) return fail(cmd, ERR_Y_NO_VALUE);
+                    if ((err = parseNumber(numStart, p, v)) != ERR_NONE) return fail(cmd, err);
+                    cmd.hasY = true;
+                    cmd.y = v;
+                    break;
+                case 'F':
+                    if (!hasNumber) return fail(cmd, ERR_F_NO_VALUE);
+                    if ((err = parseNumber(numStart, p, v)) != ERR_NONE) return fail(cmd, err);
+                    if (v.whole < 0 || v.micro < 0) return fail(cmd, ERR_NEGATIVE_FEED);
+                    cmd.hasF = true;
+                    cmd.f = v;
+                    break;
+                case 'I':
+                    if (!hasNumber) return fail(cmd, ERR_I_NO_VALUE);
+                    if ((err = parseNumber(numStart, p, v)) != ERR_NONE) return fail(cmd, err);
+                    cmd.hasI = true;
+                    cmd.i = v;
+                    break;
+                case 'J':
+                    if (!hasNumber) return fail(cmd, ERR_J_NO_VALUE);
+                    if ((err = parseNumber(numStart, p, v)) != ERR_NONE) return fail(cmd, err);
+                    cmd.hasJ = true;
+                    cmd.j = v;
+                    break;
+                case 'R':
+                    if (!hasNumber) return fail(cmd, ERR_R_NO_VALUE);
+                    if ((err = parseNumber(numStart, p, v)) != ERR_NONE) return fail(cmd, err);
+                    cmd.hasR = true;
+                    cmd.r = v;
+                    break;
+                case 'S': {
+                    if (!hasNumber) return fail(cmd, ERR_S_NO_VALUE);
+                    if ((err = parseNumber(numStart, p, v)) != ERR_NONE) return fail(cmd, err);
+                    int32_t iv = v.whole;
+                    if (iv < 0 || iv > 255) return fail(cmd, ERR_S_OUT_OF_RANGE);
+                    cmd.hasS = true;
+                    cmd.s = (int)iv;
+                    break;
+                }
+                default:
+                    // ignore other letters gracefully (could be comments, tool number, etc.)
+                    // but if they had a number and we don't recognize it, just skip.
+                    break;
             }
         }
 
+        if (!sawWord) return fail(cmd, ERR_EMPTY_LINE);
+
         // Determine command type priority: M takes precedence if M3, otherwise G settings.
         if (mNumber == 3) {
             cmd.type = TYPE_M3;
@@ -144,71 +201,180 @@ public:
         if (gNumber >= 0) {
             if (gNumber == 0) {
                 cmd.type = TYPE_G0;
-                cmd.valid = true;
-                return cmd;
             } else if (gNumber == 1) {
-                cmd.type = TYPE_G1;
-                // F is optional
-                cmd.valid = true;
-                return cmd;
+                cmd.type = TYPE_G1; // F is optional
+            } else if (gNumber == 2 || gNumber == 3) {
+                // Arcs need exactly one way of locating the center
+                bool hasCenter = cmd.hasI || cmd.hasJ;
+                if (hasCenter == cmd.hasR) return fail(cmd, ERR_ARC_CENTER);
+                cmd.type = (gNumber == 2) ? TYPE_G2 : TYPE_G3;
             } else if (gNumber == 28) {
                 cmd.type = TYPE_G28;
-                cmd.valid = true;
-                return cmd;
             } else {
-                cmd.valid = false;
-                cmd.error = F("Unsupported G-code number");
-                return cmd;
+                return fail(cmd, ERR_UNSUPPORTED_G);
             }
+            cmd.valid = true;
+            return cmd;
         }
 
-        cmd.valid = false;
-        cmd.error = F("No supported G/M command found");
-        return cmd;
+        return fail(cmd, ERR_NO_COMMAND);
     }
 
-    // Convenience overloads for Arduino C-string inputs
+    // Convenience overloads for Arduino String and C-string inputs
     static Command parseLine(const char* rawLine) {
-        return parseLine(String(rawLine ? rawLine : ""));
+        return parseLine(rawLine, rawLine ? strlen(rawLine) : 0);
+    }
+    static Command parseLine(const String& rawLine) {
+        return parseLine(rawLine.c_str(), rawLine.length());
+    }
+
+    // Human readable message for an error code. Strings are stored in flash.
+    static const __FlashStringHelper* errorMessage(Error err) {
+        switch (err) {
+            case ERR_NONE:                return F("No error");
+            case ERR_EMPTY_LINE:          return F("Empty line");
+            case ERR_UNEXPECTED_CHAR:     return F("Unexpected character in input");
+            case ERR_G_NO_NUMBER:         return F("G with no number");
+            case ERR_M_NO_NUMBER:         return F("M with no number");
+            case ERR_X_NO_VALUE:          return F("X with no value");
+            case ERR_Y_NO_VALUE:          return F("Y with no value");
+            case ERR_F_NO_VALUE:          return F("F with no value");
+            case ERR_S_NO_VALUE:          return F("S with no value");
+            case ERR_I_NO_VALUE:          return F("I with no value");
+            case ERR_J_NO_VALUE:          return F("J with no value");
+            case ERR_R_NO_VALUE:          return F("R with no value");
+            case ERR_ARC_CENTER:          return F("G2/G3 needs I/J or R (not both)");
+            case ERR_ARC_END_POINT:       return F("Invalid arc (end point not on the circle)");
+            case ERR_NEGATIVE_FEED:       return F("Feed rate F must be non-negative");
+            case ERR_S_OUT_OF_RANGE:      return F("S value out of range 0-255");
+            case ERR_INVALID_NUMBER:      return F("Invalid number format");
+            case ERR_NUMBER_OUT_OF_RANGE: return F("Numeric out of range");
+            case ERR_UNSUPPORTED_G:       return F("Unsupported G-code number");
+            case ERR_NO_COMMAND:          return F("No supported G/M command found");
+        }
+        return F("Unknown error");
+    }
+
+    // Convert a parsed value to whole steps, rounding to nearest (halves away from zero).
+    // stepsPerUnit must be 1..FIXED_MAX_STEPS_PER_UNIT. Returns ERR_NUMBER_OUT_OF_RANGE, and
+    // leaves `steps` alone, if the result does not fit in a long.
+    static Error toSteps(const Fixed& v, long stepsPerUnit, long& steps) {
+        long fraction = (long)v.micro * stepsPerUnit;
+        long rounded = fraction / (long)FIXED_ONE; // |rounded| <= stepsPerUnit
+        long rest = fraction % (long)FIXED_ONE;
+        if (rest >= (long)(FIXED_ONE / 2)) rounded++;
+        else if (rest <= -(long)(FIXED_ONE / 2)) rounded--;
+        if (v.whole > 0 && v.whole > (LONG_MAX - rounded) / stepsPerUnit) return ERR_NUMBER_OUT_OF_RANGE;
+        if (v.whole < 0 && v.whole < (LONG_MIN - rounded) / stepsPerUnit) return ERR_NUMBER_OUT_OF_RANGE;
+        steps = (long)v.whole * stepsPerUnit + rounded;
+        return ERR_NONE;
+    }
+
+    // Floating point view of a value, for printing and host-side checks (not used on the hot path).
+    static double toDouble(const Fixed& v) {
+        return (double)v.whole + (double)v.micro / (double)FIXED_ONE;
     }
 
 private:
-    // Helper: strip comments started by ';' or '(' (parenthesis-style comments)
-    static String stripComments(const String& s) {
-        // Copy up to ';'
-        int pos = s.indexOf(';');
-        String out = (pos >= 0) ? s.substring(0, pos) : s;
-        // remove parentheses and anything inside them
-        String tmp;
-        tmp.reserve(out.length());
-        bool inParen = false;
-        for (uint16_t i = 0; i < out.length(); ++i) {
-            char c = out.charAt(i);
-            if (c == '(') { inParen = true; continue; }
-            if (c == ')') { inParen = false; continue; }
-            if (!inParen) tmp += c;
+    static Command& fail(Command& cmd, Error err) {
+        cmd.valid = false;
+        cmd.error = err;
+        return cmd;
+    }
+
+    // Advance past a number token: optional sign, digits, decimal point, exponent.
+    static const char* scanNumber(const char* p, const char* end) {
+        if (p < end && (*p == '+' || *p == '-')) ++p;
+        while (p < end && isdigit((unsigned char)*p)) ++p;
+        if (p < end && *p == '.') {
+            ++p;
+            while (p < end && isdigit((unsigned char)*p)) ++p;
+        }
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            const char* epos = p;
+            ++p;
+            if (p < end && (*p == '+' || *p == '-')) ++p;
+            const char* expStart = p;
+            while (p < end && isdigit((unsigned char)*p)) ++p;
+            if (p == expStart) {
+                // malformed exponent: rollback to before 'e' (treat as end of token)
+                p = epos;
+            }
         }
-        return tmp;
+        return p;
     }
 
-    // Parse a floating point number from text. On error, sets err and returns 0.
-    static double parseDouble(const String& text, String& err) {
-        err = "";
-        if (text.length() == 0) { err = F("Empty numeric field"); return 0.0; }
-        const char* cstr = text.c_str();
-        char* endptr = NULL;
-        errno = 0;
-        double val = strtod(cstr, &endptr);
-        if (endptr == cstr) {
-            err = F("Invalid number format");
-            return 0.0;
+    // Convert the number token text[begin, end) without copying it, straight into fixed
+    // point. Integer digits accumulate into `whole`, the first six fraction digits into
+    // `micro` (rounded on the seventh), and an exponent shifts digits between the two.
+    // Only 32-bit integer arithmetic is used.
+    static Error parseNumber(const char* p, const char* end, Fixed& out) {
+        out.whole = 0;
+        out.micro = 0;
+        bool negative = false;
+        if (p < end && (*p == '+' || *p == '-')) { negative = (*p == '-'); ++p; }
+
+        uint32_t whole = 0;
+        uint32_t micro = 0;
+        bool sawDigits = false;
+        while (p < end && isdigit((unsigned char)*p)) {
+            sawDigits = true;
+            uint32_t d = (uint32_t)(*p - '0');
+            if (whole > (FIXED_WHOLE_MAX - d) / 10) return ERR_NUMBER_OUT_OF_RANGE;
+            whole = whole * 10 + d;
+            ++p;
         }
-        if (errno == ERANGE) {
-            err = F("Numeric out of range");
-            return 0.0;
+        if (p < end && *p == '.') {
+            ++p;
+            uint32_t place = FIXED_ONE / 10;
+            uint8_t fractionDigits = 0;
+            bool roundUp = false;
+            while (p < end && isdigit((unsigned char)*p)) {
+                sawDigits = true;
+                uint32_t d = (uint32_t)(*p - '0');
+                if (place > 0) { micro += d * place; place /= 10; }
+                else if (fractionDigits == FIXED_DECIMALS) roundUp = (d >= 5); // seventh digit rounds
+                fractionDigits++;
+                ++p;
+            }
+            if (roundUp) micro++;
         }
-        return val;
+        if (!sawDigits) return ERR_INVALID_NUMBER;
+
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            ++p;
+            bool expNegative = false;
+            if (p < end && (*p == '+' || *p == '-')) { expNegative = (*p == '-'); ++p; }
+            int e = 0;
+            while (p < end && isdigit((unsigned char)*p)) {
+                if (e < 100) e = e * 10 + (*p - '0');
+                ++p;
+            }
+            if (p != end) return ERR_INVALID_NUMBER;
+            if (!expNegative) {
+                for (; e > 0 && (whole || micro); e--) {
+                    uint32_t carry = micro / (FIXED_ONE / 10);
+                    if (whole > (FIXED_WHOLE_MAX - carry) / 10) return ERR_NUMBER_OUT_OF_RANGE;
+                    whole = whole * 10 + carry;
+                    micro = (micro % (FIXED_ONE / 10)) * 10;
+                }
+            } else {
+                for (; e > 0 && (whole || micro); e--) {
+                    uint32_t r = micro % 10;
+                    micro = micro / 10 + (whole % 10) * (FIXED_ONE / 10);
+                    whole /= 10;
+                    if (e == 1 && r >= 5) micro++; // round on the last shift
+                }
+            }
+        }
+        if (p != end) return ERR_INVALID_NUMBER;
+
+        if (micro >= FIXED_ONE) { micro -= FIXED_ONE; whole++; }
+        if (whole > FIXED_WHOLE_MAX) return ERR_NUMBER_OUT_OF_RANGE;
+        out.whole = negative ? -(int32_t)whole : (int32_t)whole;
+        out.micro = negative ? -(int32_t)micro : (int32_t)micro;
+        return ERR_NONE;
     }
 };
 
-#endif // GCODE_PARSER_H
\ No newline at end of file
+#endif // GCODE_PARSER_H
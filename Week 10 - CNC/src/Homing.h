@@ -0,0 +1,146 @@
+#ifndef HOMING_H
+#define HOMING_H
+
+// Homing.h
+// Non-blocking homing cycle for the CNC controller.
+// Homing runs as a state machine driven from loop(), so the step engine keeps being fed
+// and serial input is still read while the axes home:
+//  - SYNC:    wait for every queued move to finish.
+//  - SEEK:    both axes run towards their min switches at the seek speed; the step
+//             interrupt stops each axis on its own switch.
+//  - BACKOFF: both axes move off the switches by the back-off distance.
+//  - RESEEK:  both axes approach the switches again at the (slow) re-seek speed. The
+//             switch positions found here become the zero point, so the result does not
+//             depend on how far the fast seek overran.
+// A timeout, a switch that is never found or a switch that is still pressed after the
+// back-off end the cycle in FAILED with all motion stopped.
+
+#include <Arduino.h>
+#include "Planner.h"
+#include "StepEngine.h"
+
+class Homing {
+public:
+    enum State {
+        HOMING_IDLE = 0,
+        HOMING_SYNC,
+        HOMING_SEEK,
+        HOMING_BACKOFF,
+        HOMING_RESEEK,
+        HOMING_DONE,
+        HOMING_FAILED
+    };
+
+    Homing(StepEngine& engine, Planner& planner)
+        : _engine(engine), _planner(planner), _state(HOMING_IDLE), _seekSpeed(800.0f),
+          _reseekSpeed(100.0f), _backoff(50), _travel(10000), _start(0), _timeout(0) {}
+
+    // Speeds in steps/s
+    void setSpeeds(float seek, float reseek) {
+        _seekSpeed = fabs(seek);
+        _reseekSpeed = fabs(reseek);
+    }
+    // Distance moved off the switches before the re-seek (steps)
+    void setBackoff(long steps) { _backoff = labs(steps); }
+    // Longest seek before giving up on finding a switch (steps)
+    void setTravel(long steps) { _travel = labs(steps); }
+
+    // Start a homing cycle after the moves already queued. timeoutMs = 0 waits forever.
+    void start(unsigned long timeoutMs = 0) {
+        _start = millis();
+        _timeout = timeoutMs;
+        _state = HOMING_SYNC;
+    }
+
+    // Abort a running cycle and stop all motion
+    void cancel() {
+        if (isActive()) _fail();
+    }
+
+    // Call from loop() together with the step engine's prepare()/service().
+    State update() {
+        if (!isActive()) return (State)_state;
+        if (_timeout && (millis() - _start) >= _timeout) {
+            _fail();
+            return (State)_state;
+        }
+        bool idle = _engine.isIdle() && _planner.isEmpty();
+        switch (_state) {
+        case HOMING_SYNC:
+            if (!idle) break;
+            _approach(_travel, _seekSpeed);
+            _state = HOMING_SEEK;
+            break;
+        case HOMING_SEEK:
+            if (_engine.limitsHit() == 0x03) {
+                _zero();
+                _planner.addLine(_backoff, _backoff, _reseekSpeed * 4.0f);
+                _state = HOMING_BACKOFF;
+            } else if (idle) {
+                _fail(); // ran the whole travel without finding both switches
+            }
+            break;
+        case HOMING_BACKOFF:
+            if (!idle) break;
+            if (_engine.limitPressed(0) || _engine.limitPressed(1)) {
+                _fail();
+                break;
+            }
+            _approach(_backoff * 2, _reseekSpeed);
+            _state = HOMING_RESEEK;
+            break;
+        case HOMING_RESEEK:
+            if (_engine.limitsHit() == 0x03) {
+                _zero();
+                _state = HOMING_DONE;
+            } else if (idle) {
+                _fail();
+            }
+            break;
+        default:
+            break;
+        }
+        return (State)_state;
+    }
+
+    bool isActive() const { return _state > HOMING_IDLE && _state < HOMING_DONE; }
+    State state() const { return (State)_state; }
+
+private:
+    StepEngine& _engine;
+    Planner& _planner;
+    uint8_t _state;
+    float _seekSpeed;
+    float _reseekSpeed;
+    long _backoff;
+    long _travel;
+    unsigned long _start;
+    unsigned long _timeout;
+
+    // Move both axes up to `distance` towards their switches with the limits armed
+    void _approach(long distance, float speed) {
+        _engine.setPosition(0, 0);
+        _planner.setPosition(0, 0);
+        _engine.enableLimits(true);
+        _planner.addLine(-distance, -distance, speed);
+    }
+
+    // Stop at the switches and make them the origin
+    void _zero() {
+        _engine.stop();
+        _planner.clear();
+        _engine.enableLimits(false);
+        _engine.setPosition(0, 0);
+        _planner.setPosition(0, 0);
+    }
+
+    void _fail() {
+        _engine.stop();
+        _planner.clear();
+        _engine.enableLimits(false);
+        _planner.setPosition(_engine.getPosition(0), _engine.getPosition(1));
+        _state = HOMING_FAILED;
+    }
+};
+
+#endif // HOMING_H
@@ -0,0 +1,213 @@
+#ifndef PLANNER_H
+#define PLANNER_H
+
+// Planner.h
+// Look-ahead motion planner for the CNC controller.
+// Linear moves are queued in a small ring buffer. Every time a move is added the
+// entry speed of each queued block is recomputed so that consecutive segments blend
+// through their junctions instead of stopping, while never exceeding the configured
+// acceleration. Junction speeds are limited with the junction-deviation model:
+// the tool is allowed to cut the corner by at most `junctionDeviation` steps.
+//
+// All distances are in steps, speeds in steps/sec and acceleration in steps/sec^2.
+// Speeds are stored squared so the planner passes need no square roots.
+
+#include <Arduino.h>
+#include <math.h>
+
+#ifndef PLANNER_BUFFER_SIZE
+#define PLANNER_BUFFER_SIZE 8
+#endif
+
+#define PLANNER_AXES 2
+
+class Planner {
+public:
+    struct Block {
+        long target[PLANNER_AXES];   // absolute end position (steps)
+        long steps[PLANNER_AXES];    // signed step delta for this block
+        float length;                // euclidean length (steps)
+        float unit[PLANNER_AXES];    // direction unit vector
+        float nominalSpeedSqr;       // requested feed, squared
+        float maxEntrySpeedSqr;      // junction limit with the previous block, squared
+        float entrySpeedSqr;         // planned entry speed, squared
+        float acceleration;
+    };
+
+    Planner()
+        : _head(0), _tail(0), _count(0), _busy(false),
+          _acceleration(800.0f), _junctionDeviation(2.0f)
+    {
+        _position[0] = 0;
+        _position[1] = 0;
+        _prevUnit[0] = 0.0f;
+        _prevUnit[1] = 0.0f;
+        _prevNominalSpeedSqr = 0.0f;
+    }
+
+    void setAcceleration(float stepsPerSec2) { _acceleration = fabs(stepsPerSec2); }
+    float getAcceleration() const { return _acceleration; }
+
+    // Maximum corner deviation (steps). Larger values allow faster cornering.
+    void setJunctionDeviation(float steps) { _junctionDeviation = fabs(steps); }
+    float getJunctionDeviation() const { return _junctionDeviation; }
+
+    // Reset the planned position (e.g. after homing). Only valid while the buffer is empty.
+    void setPosition(long x, long y) {
+        _position[0] = x;
+        _position[1] = y;
+        _prevNominalSpeedSqr = 0.0f;
+    }
+    long getPosition(uint8_t axis) const { return _position[axis]; }
+
+    // Drop every queued block (e.g. after an aborted move). The planned position is kept.
+    void clear() {
+        _head = 0;
+        _tail = 0;
+        _count = 0;
+        _busy = false;
+    }
+
+    uint8_t count() const { return _count; }
+    bool isEmpty() const { return _count == 0; }
+    bool isFull() const { return _count >= PLANNER_BUFFER_SIZE; }
+
+    // Queue a linear move to (x, y) at `feed` steps/sec along the path.
+    // Returns false if the buffer is full. Zero length moves are accepted and dropped.
+    bool addLine(long x, long y, float feed) {
+        if (isFull()) return false;
+        Block& b = _buffer[_head];
+        b.target[0] = x;
+        b.target[1] = y;
+        b.steps[0] = x - _position[0];
+        b.steps[1] = y - _position[1];
+        if (b.steps[0] == 0 && b.steps[1] == 0) return true;
+
+        float dx = (float)b.steps[0];
+        float dy = (float)b.steps[1];
+        b.length = sqrt(dx * dx + dy * dy);
+        b.unit[0] = dx / b.length;
+        b.unit[1] = dy / b.length;
+        b.acceleration = _acceleration;
+        b.nominalSpeedSqr = feed * feed;
+        b.entrySpeedSqr = 0.0f;
+
+        // Junction speed with the previous block. The first block after the
+        // buffer ran dry always starts from rest.
+        if (_count == 0 && !_busy) {
+            b.maxEntrySpeedSqr = 0.0f;
+        } else {
+            b.maxEntrySpeedSqr = _junctionSpeedSqr(b);
+        }
+
+        _prevUnit[0] = b.unit[0];
+        _prevUnit[1] = b.unit[1];
+        _prevNominalSpeedSqr = b.nominalSpeedSqr;
+        _position[0] = x;
+        _position[1] = y;
+
+        _head = _next(_head);
+        _count++;
+        _recalculate();
+        return true;
+    }
+
+    // Block currently being executed (oldest in the buffer), or NULL if empty.
+    // Once fetched, the block's entry speed is frozen until it is discarded.
+    Block* currentBlock() {
+        if (_count == 0) return NULL;
+        _busy = true;
+        return &_buffer[_tail];
+    }
+
+    // Drop the executed block and advance to the next one. The machine is already
+    // moving at the next block's entry speed, so that block stays frozen too.
+    void discardCurrentBlock() {
+        if (_count == 0) return;
+        _tail = _next(_tail);
+        _count--;
+        _busy = (_count > 0);
+    }
+
+    // Speed (squared) at which `b` must leave: the entry of the next queued block,
+    // or zero when nothing follows it yet.
+    float exitSpeedSqr(const Block* b) const {
+        uint8_t idx = (uint8_t)(b - _buffer);
+        uint8_t nextIdx = _next(idx);
+        if (nextIdx == _head) return 0.0f;
+        return _buffer[nextIdx].entrySpeedSqr;
+    }
+
+    // Trapezoidal speed profile of `b` at `distance` steps from its start.
+    // Accelerates from the entry speed, cruises at the nominal speed and
+    // decelerates to the exit speed, all at the block's acceleration.
+    float speedAt(const Block* b, float distance) const {
+        float twoA = 2.0f * b->acceleration;
+        float v2 = b->entrySpeedSqr + twoA * distance;
+        float remaining = b->length - distance;
+        if (remaining < 0.0f) remaining = 0.0f;
+        float decel2 = exitSpeedSqr(b) + twoA * remaining;
+        if (decel2 < v2) v2 = decel2;
+        if (b->nominalSpeedSqr < v2) v2 = b->nominalSpeedSqr;
+        return sqrt(v2);
+    }
+
+private:
+    Block _buffer[PLANNER_BUFFER_SIZE];
+    uint8_t _head;   // next free slot
+    uint8_t _tail;   // oldest block (executing)
+    uint8_t _count;
+    bool _busy;      // tail block is being executed (entry speed frozen)
+    float _acceleration;
+    float _junctionDeviation;
+    long _position[PLANNER_AXES];
+    float _prevUnit[PLANNER_AXES];
+    float _prevNominalSpeedSqr;
+
+    static uint8_t _next(uint8_t i) { return (uint8_t)((i + 1) % PLANNER_BUFFER_SIZE); }
+    static uint8_t _prev(uint8_t i) { return (uint8_t)((i + PLANNER_BUFFER_SIZE - 1) % PLANNER_BUFFER_SIZE); }
+
+    // Maximum speed (squared) through the corner between the previous block and `b`.
+    float _junctionSpeedSqr(const Block& b) const {
+        float limit = (b.nominalSpeedSqr < _prevNominalSpeedSqr) ? b.nominalSpeedSqr : _prevNominalSpeedSqr;
+        // cosTheta is the cosine of the angle between the two path directions,
+        // measured so that -1 means straight through and +1 means a full reversal.
+        float cosTheta = -(_prevUnit[0] * b.unit[0] + _prevUnit[1] * b.unit[1]);
+        if (cosTheta > 0.999999f) return 0.0f;   // reversal: must stop
+        if (cosTheta < -0.999999f) return limit; // straight line
+        float sinHalfTheta = sqrt(0.5f * (1.0f - cosTheta));
+        float v2 = b.acceleration * _junctionDeviation * sinHalfTheta / (1.0f - sinHalfTheta);
+        return (v2 < limit) ? v2 : limit;
+    }
+
+    // Re-plan entry speeds for every queued block.
+    // Reverse pass: the newest block must be able to stop at its end, and every block must
+    // be able to decelerate to its successor's entry speed.
+    // Forward pass: no block may be entered faster than its predecessor can accelerate to.
+    void _recalculate() {
+        if (_count == 0) return;
+
+        uint8_t idx = _prev(_head);
+        float nextEntrySqr = 0.0f; // newest block exits at rest
+        // The executing block (tail while busy) keeps its entry speed.
+        uint8_t planable = _busy ? _count - 1 : _count;
+        for (uint8_t i = 0; i < planable; i++) {
+            Block& b = _buffer[idx];
+            float reachable = nextEntrySqr + 2.0f * b.acceleration * b.length;
+            b.entrySpeedSqr = (reachable < b.maxEntrySpeedSqr) ? reachable : b.maxEntrySpeedSqr;
+            nextEntrySqr = b.entrySpeedSqr;
+            idx = _prev(idx);
+        }
+
+        idx = _tail;
+        for (uint8_t i = 0; i + 1 < _count; i++) {
+            Block& b = _buffer[idx];
+            Block& n = _buffer[_next(idx)];
+            float reachable = b.entrySpeedSqr + 2.0f * b.acceleration * b.length;
+            if (n.entrySpeedSqr > reachable) n.entrySpeedSqr = reachable;
+            idx = _next(idx);
+        }
+    }
+};
+
+#endif // PLANNER_H
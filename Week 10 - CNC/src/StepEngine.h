@@ -0,0 +1,374 @@
+#ifndef STEP_ENGINE_H
+#define STEP_ENGINE_H
+
+// StepEngine.h
+// Timer-interrupt step generator for the CNC controller.
+// The foreground (prepare()) slices planner blocks into short constant-rate segments and
+// pushes them into a fixed queue. A hardware timer interrupt consumes the queue: every tick
+// is one major-axis step and a Bresenham/DDA counter decides which other axes step with it.
+// The timer period is reloaded from the segment on every tick, so the step rate follows the
+// planner's speed profile without loop() ever touching the step pins.
+//
+// On AVR the engine uses Timer1 (CTC, /8 prescaler) and direct port writes. It defines the
+// TIMER1_COMPA ISR, so include this header from a single translation unit only.
+// On other targets service() must be called from loop() and steps are timed with micros().
+
+#include <Arduino.h>
+#include "Planner.h"
+
+#ifndef STEP_SEGMENT_BUFFER_SIZE
+#define STEP_SEGMENT_BUFFER_SIZE 16
+#endif
+
+#ifndef STEP_SEGMENT_TIME_US
+#define STEP_SEGMENT_TIME_US 5000UL // target duration of one segment
+#endif
+
+#if defined(__AVR__)
+#define STEP_TIMER_HZ (F_CPU / 8UL)
+#else
+#define STEP_TIMER_HZ 1000000UL
+#endif
+
+#define STEP_MIN_PERIOD (STEP_TIMER_HZ / 40000UL) // caps the step rate at 40 kHz
+
+class StepEngine {
+public:
+    StepEngine(uint8_t xStepPin, uint8_t xDirPin, uint8_t yStepPin, uint8_t yDirPin)
+        : _segHead(0), _segTail(0), _blockHead(0), _curBlock(0xFF),
+          _segStepsLeft(0), _period(0), _stepMask(0), _running(false),
+          _limitsEnabled(false), _limitActiveLow(true), _limitHit(0),
+          _prepBlock(NULL), _prepStepsDone(0), _minSpeed(40.0f), _lastTickMicros(0)
+    {
+        _stepPin[0] = xStepPin; _dirPin[0] = xDirPin;
+        _stepPin[1] = yStepPin; _dirPin[1] = yDirPin;
+        _limitPin[0] = 0; _limitPin[1] = 0;
+        _position[0] = 0; _position[1] = 0;
+        _counter[0] = 0; _counter[1] = 0;
+    }
+
+    // Call in setup()
+    void begin() {
+        instance() = this;
+        for (uint8_t a = 0; a < PLANNER_AXES; a++) {
+            pinMode(_stepPin[a], OUTPUT);
+            pinMode(_dirPin[a], OUTPUT);
+            digitalWrite(_stepPin[a], LOW);
+#if defined(__AVR__)
+            _stepReg[a] = portOutputRegister(digitalPinToPort(_stepPin[a]));
+            _stepBit[a] = digitalPinToBitMask(_stepPin[a]);
+            _dirReg[a] = portOutputRegister(digitalPinToPort(_dirPin[a]));
+            _dirBit[a] = digitalPinToBitMask(_dirPin[a]);
+#endif
+        }
+#if defined(__AVR__)
+        noInterrupts();
+        TCCR1A = 0;
+        TCCR1B = (1 << WGM12) | (1 << CS11); // CTC on OCR1A, clk/8
+        TCNT1 = 0;
+        OCR1A = 0xFFFF;
+        TIMSK1 &= ~(1 << OCIE1A);
+        interrupts();
+#endif
+    }
+
+    // Minimum path speed (steps/s) used when starting from rest.
+    void setMinSpeed(float stepsPerSec) { _minSpeed = fabs(stepsPerSec); }
+
+    // Optional min-limit switches. While enabled, an axis moving towards its switch stops
+    // stepping as soon as the switch reads pressed and the axis is flagged in limitsHit().
+    void setLimitPins(uint8_t xMinPin, uint8_t yMinPin, bool activeLow = true) {
+        _limitPin[0] = xMinPin;
+        _limitPin[1] = yMinPin;
+        _limitActiveLow = activeLow;
+#if defined(__AVR__)
+        for (uint8_t a = 0; a < PLANNER_AXES; a++) {
+            _limitReg[a] = portInputRegister(digitalPinToPort(_limitPin[a]));
+            _limitBit[a] = digitalPinToBitMask(_limitPin[a]);
+        }
+#endif
+    }
+    void enableLimits(bool enabled) {
+        noInterrupts();
+        _limitsEnabled = enabled;
+        _limitHit = 0;
+        interrupts();
+    }
+    uint8_t limitsHit() const { return _limitHit; }
+    // Current state of an axis's min switch, whether or not the limits are enabled
+    bool limitPressed(uint8_t axis) const { return _limitPressed(axis); }
+
+    // Foreground: slice planner blocks into segments until the queue is full.
+    // A planner block is discarded as soon as all of its steps have been queued.
+    void prepare(Planner& planner) {
+        while (_nextSeg(_segHead) != _segTail) {
+            if (_prepBlock == NULL) {
+                _prepBlock = planner.currentBlock();
+                if (_prepBlock == NULL) break;
+                StepBlock& sb = _blocks[_blockHead];
+                sb.major = 0;
+                sb.dirBits = 0;
+                for (uint8_t a = 0; a < PLANNER_AXES; a++) {
+                    long s = _prepBlock->steps[a];
+                    sb.steps[a] = (unsigned long)labs(s);
+                    if (s < 0) sb.dirBits |= (1 << a);
+                    if (sb.steps[a] > sb.major) sb.major = sb.steps[a];
+                }
+                _prepBlockIndex = _blockHead;
+                _blockHead = _nextSeg(_blockHead);
+                _prepStepsDone = 0;
+            }
+
+            StepBlock& sb = _blocks[_prepBlockIndex];
+            float stepsPerUnit = (float)sb.major / _prepBlock->length; // major steps per path step
+
+            // Size the segment from the speed at its start, then time it with the speed at its middle.
+            float v = planner.speedAt(_prepBlock, _prepStepsDone / stepsPerUnit);
+            if (v < _minSpeed) v = _minSpeed;
+            unsigned long n = (unsigned long)(v * stepsPerUnit * (STEP_SEGMENT_TIME_US / 1000000.0f));
+            if (n < 1) n = 1;
+            if (n > 0xFFFF) n = 0xFFFF;
+            unsigned long remaining = sb.major - _prepStepsDone;
+            if (n > remaining) n = remaining;
+
+            v = planner.speedAt(_prepBlock, (_prepStepsDone + n * 0.5f) / stepsPerUnit);
+            if (v < _minSpeed) v = _minSpeed;
+            float period = (float)STEP_TIMER_HZ / (v * stepsPerUnit);
+            if (period < STEP_MIN_PERIOD) period = STEP_MIN_PERIOD;
+            if (period > 65535.0f) period = 65535.0f;
+
+            Segment& seg = _segments[_segHead];
+            seg.block = _prepBlockIndex;
+            seg.steps = (uint16_t)n;
+            seg.period = (uint16_t)period;
+            _segHead = _nextSeg(_segHead);
+
+            _prepStepsDone += n;
+            if (_prepStepsDone >= sb.major) {
+                planner.discardCurrentBlock();
+                _prepBlock = NULL;
+            }
+            _start();
+        }
+    }
+
+#if !defined(__AVR__)
+    // Software timer for targets without the Timer1 backend. Call as often as possible.
+    void service() {
+        if (!_running) return;
+        unsigned long now = micros();
+        if ((now - _lastTickMicros) >= _period) {
+            _lastTickMicros = now;
+            _tick();
+        }
+    }
+#endif
+
+    // True when no segment is queued or executing.
+    bool isIdle() const { return !_running && _segHead == _segTail && _prepBlock == NULL; }
+
+    // Abort all motion immediately and flush the segment queue (planner is left untouched).
+    void stop() {
+        noInterrupts();
+        _haltTimer();
+        _segTail = _segHead;
+        _segStepsLeft = 0;
+        _stepMask = 0;
+        _curBlock = 0xFF;
+        _prepBlock = NULL;
+        interrupts();
+    }
+
+    long getPosition(uint8_t axis) const {
+        noInterrupts();
+        long p = _position[axis];
+        interrupts();
+        return p;
+    }
+    void setPosition(long x, long y) {
+        noInterrupts();
+        _position[0] = x;
+        _position[1] = y;
+        interrupts();
+    }
+
+    // Timer interrupt entry point.
+    void _tick() {
+        // Rising edge for the steps scheduled on the previous tick
+        uint8_t mask = _stepMask;
+        for (uint8_t a = 0; a < PLANNER_AXES; a++) {
+            if (mask & (1 << a)) {
+                _writeStep(a, true);
+                _position[a] += (_dirBits & (1 << a)) ? -1 : 1;
+            }
+        }
+        if (!_advance()) {
+            _haltTimer();
+        }
+        for (uint8_t a = 0; a < PLANNER_AXES; a++) {
+            if (mask & (1 << a)) _writeStep(a, false);
+        }
+    }
+
+    static StepEngine*& instance() {
+        static StepEngine* engine = NULL;
+        return engine;
+    }
+
+private:
+    struct StepBlock {
+        unsigned long steps[PLANNER_AXES]; // absolute steps per axis
+        unsigned long major;               // steps on the dominant axis
+        uint8_t dirBits;                   // bit set = negative direction
+    };
+    struct Segment {
+        uint8_t block;   // index into _blocks
+        uint16_t steps;  // major-axis steps in this segment
+        uint16_t period; // timer ticks between major-axis steps
+    };
+
+    uint8_t _stepPin[PLANNER_AXES], _dirPin[PLANNER_AXES], _limitPin[PLANNER_AXES];
+#if defined(__AVR__)
+    volatile uint8_t* _stepReg[PLANNER_AXES];
+    volatile uint8_t* _dirReg[PLANNER_AXES];
+    volatile uint8_t* _limitReg[PLANNER_AXES];
+    uint8_t _stepBit[PLANNER_AXES], _dirBit[PLANNER_AXES], _limitBit[PLANNER_AXES];
+#endif
+
+    // Queues shared with the interrupt: head is written by the foreground, tail by the ISR
+    StepBlock _blocks[STEP_SEGMENT_BUFFER_SIZE];
+    Segment _segments[STEP_SEGMENT_BUFFER_SIZE];
+    volatile uint8_t _segHead;
+    volatile uint8_t _segTail;
+    uint8_t _blockHead;
+
+    // Interrupt state
+    uint8_t _curBlock;
+    uint8_t _dirBits;
+    uint16_t _segStepsLeft;
+    uint16_t _period;
+    long _counter[PLANNER_AXES];
+    volatile long _position[PLANNER_AXES];
+    volatile uint8_t _stepMask;
+    volatile bool _running;
+    volatile bool _limitsEnabled;
+    bool _limitActiveLow;
+    volatile uint8_t _limitHit;
+
+    // Foreground segment preparation state
+    Planner::Block* _prepBlock;
+    uint8_t _prepBlockIndex;
+    unsigned long _prepStepsDone;
+    float _minSpeed;
+    unsigned long _lastTickMicros;
+
+    static uint8_t _nextSeg(uint8_t i) { return (uint8_t)((i + 1) % STEP_SEGMENT_BUFFER_SIZE); }
+
+    // Compute the step mask and period of the next tick. Returns false when the queue ran dry.
+    bool _advance() {
+        if (_segStepsLeft == 0) {
+            if (_segTail == _segHead) { _stepMask = 0; return false; }
+            const Segment& seg = _segments[_segTail];
+            if (seg.block != _curBlock) {
+                const StepBlock& sb = _blocks[seg.block];
+                _curBlock = seg.block;
+                _dirBits = sb.dirBits;
+                for (uint8_t a = 0; a < PLANNER_AXES; a++) {
+                    _counter[a] = -(long)(sb.major >> 1);
+                    _writeDir(a, !(_dirBits & (1 << a)));
+                }
+            }
+            _segStepsLeft = seg.steps;
+            _period = seg.period;
+            _segTail = _nextSeg(_segTail); // segment copied, slot can be reused
+        }
+
+        const StepBlock& sb = _blocks[_curBlock];
+        uint8_t mask = 0;
+        for (uint8_t a = 0; a < PLANNER_AXES; a++) {
+            _counter[a] += sb.steps[a];
+            if (_counter[a] > 0) {
+                _counter[a] -= sb.major;
+                mask |= (1 << a);
+            }
+        }
+        if (_limitsEnabled) {
+            for (uint8_t a = 0; a < PLANNER_AXES; a++) {
+                if ((_dirBits & (1 << a)) && _limitPressed(a)) {
+                    _limitHit |= (1 << a);
+                    mask &= ~(1 << a);
+                }
+            }
+        }
+        _segStepsLeft--;
+        _stepMask = mask;
+        _setPeriod(_period);
+        return true;
+    }
+
+    // Kick the timer if it is not already running.
+    void _start() {
+        if (_running) return;
+        noInterrupts();
+        if (_advance()) {
+            _running = true;
+#if defined(__AVR__)
+            TCNT1 = 0;
+            TIFR1 = (1 << OCF1A);
+            TIMSK1 |= (1 << OCIE1A);
+#else
+            _lastTickMicros = micros();
+#endif
+        }
+        interrupts();
+    }
+
+    void _haltTimer() {
+#if defined(__AVR__)
+        TIMSK1 &= ~(1 << OCIE1A);
+#endif
+        _running = false;
+    }
+
+    void _setPeriod(uint16_t ticks) {
+#if defined(__AVR__)
+        OCR1A = ticks;
+#endif
+        _period = ticks;
+    }
+
+    void _writeStep(uint8_t a, bool high) {
+#if defined(__AVR__)
+        if (high) *_stepReg[a] |= _stepBit[a];
+        else *_stepReg[a] &= ~_stepBit[a];
+#else
+        digitalWrite(_stepPin[a], high ? HIGH : LOW);
+#endif
+    }
+
+    void _writeDir(uint8_t a, bool forward) {
+#if defined(__AVR__)
+        if (forward) *_dirReg[a] |= _dirBit[a];
+        else *_dirReg[a] &= ~_dirBit[a];
+#else
+        digitalWrite(_dirPin[a], forward ? HIGH : LOW);
+#endif
+    }
+
+    bool _limitPressed(uint8_t a) const {
+#if defined(__AVR__)
+        bool high = (*_limitReg[a] & _limitBit[a]) != 0;
+#else
+        bool high = digitalRead(_limitPin[a]) == HIGH;
+#endif
+        return _limitActiveLow ? !high : high;
+    }
+};
+
+#if defined(__AVR__)
+ISR(TIMER1_COMPA_vect) {
+    StepEngine::instance()->_tick();
+}
+#endif
+
+#endif // STEP_ENGINE_H
@@ -1,12 +1,51 @@
 #include <Arduino.h>
-#include <AccelStepper.h>
-#include <MultiStepper.h>
 #include "GCodeParser.h"
+#include "Planner.h"
+#include "StepEngine.h"
+#include "ArcSegmenter.h"
+#include "Homing.h"
+#if GCODE_BENCH
+#include "GCodeBench.h"
+#endif
 
-AccelStepper xAxis(AccelStepper::DRIVER, 5, 4);
-AccelStepper yAxis(AccelStepper::DRIVER, 6, 7);
+#ifndef CNC_BAUD
+#define CNC_BAUD 9600
+#endif
 
-MultiStepper cnc;
+#ifndef GCODE_BENCH
+#define GCODE_BENCH 0 // 1 = run the parser benchmark over serial instead of the controller
+#endif
+
+#ifndef CNC_VERBOSE
+#define CNC_VERBOSE 0 // 1 = echo every line and print CMD: traces
+#endif
+
+#ifndef SERIAL_RX_BUFFER_SIZE
+#define SERIAL_RX_BUFFER_SIZE 64
+#endif
+
+#ifndef CNC_STEPS_PER_UNIT
+#define CNC_STEPS_PER_UNIT 1 // integer scale from G-code units to steps (1 = coordinates are steps)
+#endif
+#if CNC_STEPS_PER_UNIT < 1 || CNC_STEPS_PER_UNIT > FIXED_MAX_STEPS_PER_UNIT
+#error "CNC_STEPS_PER_UNIT must be between 1 and FIXED_MAX_STEPS_PER_UNIT"
+#endif
+
+#ifndef CNC_HOMING_TIMEOUT_MS
+#define CNC_HOMING_TIMEOUT_MS 30000UL
+#endif
+
+// A character-counting host never has more than the advertised RX buffer in flight,
+// so the longest line it can send is one byte short of it (the newline).
+#define LINE_MAX_LENGTH (SERIAL_RX_BUFFER_SIZE - 1)
+#define COMMAND_QUEUE_SIZE 8
+
+// Step/dir pins: X on 5/4, Y on 6/7. Steps are generated from a timer interrupt.
+StepEngine engine(5, 4, 6, 7);
+
+Planner planner;
+ArcSegmenter arc; // G2/G3 in progress, fed to the planner one segment at a time
+Homing homing(engine, planner); // G28 / power-up homing, run from loop()
 
 int xMin = 3;
 int yMin = 10;
@@ -15,152 +54,330 @@ int target = 500;
 int velocity = 800;
 int accel = 800;
 int accel_inc = 500;
+int maxFeed = 4000;            // upper limit for G1 feed (steps/s)
+float junctionDeviation = 2.0; // allowed corner deviation (steps)
+float arcTolerance = 0.5;      // allowed chord error when splitting arcs (steps)
+int homeSeek = 1600;           // fast approach to the switches (steps/s)
+int homeReseek = 200;          // slow approach that sets the origin (steps/s)
+int homeBackoff = 40;          // steps moved off the switches between the two
+float feedRate = velocity;     // current G1 feed (steps/s along the path)
 
 // Track target positions in steps (absolute)
 long curX = 0;
 long curY = 0;
 
-// Serial input buffer
-String inputLine;
+// End of the last accepted line: where the next queued move starts. Arcs are checked
+// against it before their line is acknowledged.
+long lineX = 0;
+long lineY = 0;
+
+// Serial input buffer (one line, no heap)
+char inputLine[LINE_MAX_LENGTH + 1];
+uint8_t inputLength = 0;
+bool inputOverflow = false;
+
+// Parsed commands waiting to be executed. A line is acknowledged as soon as it is
+// parsed into this queue, and serial input is left unread while the queue is full.
+// The host streams with character counting: it keeps at most the serial RX buffer
+// size of unacknowledged bytes in flight, and every line gets exactly one reply:
+// "OK", or "ERR: ..." if it was rejected. Anything the controller prints on its own
+// (homing progress and failures) is a "[MSG:...]" or "ALARM: ..." line, which a host
+// never counts as a reply.
+GCodeParser::Command commandQueue[COMMAND_QUEUE_SIZE];
+uint8_t commandHead = 0;
+uint8_t commandTail = 0;
+uint8_t commandCount = 0;
 
+bool verbose = CNC_VERBOSE;
+
+// Unsolicited status, not a reply to any line
+static void reportMessage(const __FlashStringHelper *text) {
+  Serial.print(F("[MSG:"));
+  Serial.print(text);
+  Serial.println(F("]"));
+}
+
+// Unsolicited failure, not a reply to any line
+static void reportAlarm(const __FlashStringHelper *text) {
+  Serial.print(F("ALARM: "));
+  Serial.println(text);
+}
+
+// Keep the step engine's segment queue filled from the planner.
+// This is all the foreground has to do for motion; the timer interrupt does the stepping.
+void RunPlanner() {
+  engine.prepare(planner);
+#if !defined(__AVR__)
+  engine.service();
+#endif
+}
+
+// Start homing after the queued moves; loop() runs it and no further command is
+// executed until it has finished.
 void Home() {
-  xAxis.moveTo(-10000);
-  yAxis.moveTo(-10000);
-  Serial.println("Starting home routine");
-  while (digitalRead(xMin) || digitalRead(yMin)) {
-    if (digitalRead(xMin)) {
-      xAxis.run();
-    }
-    if (digitalRead(yMin)) {
-      yAxis.run();
-    }
-    Serial.println("Homing...");
-    
+  reportMessage(F("Starting home routine"));
+  homing.start(CNC_HOMING_TIMEOUT_MS);
+}
+
+// Advance the homing cycle and report its end.
+void RunHoming() {
+  if (!homing.isActive()) return;
+  homing.update();
+  if (homing.isActive()) return;
+  if (homing.state() == Homing::HOMING_DONE) {
+    reportMessage(F("Done homing"));
+  } else {
+    reportAlarm(F("Homing failed"));
   }
-  Serial.println("Done homing");
-  xAxis.setCurrentPosition(0);
-  xAxis.moveTo(0);
-  yAxis.setCurrentPosition(0);
-  yAxis.moveTo(0);
-}
-
-void Rapid(int xPos, int yPos) {
-  xAxis.moveTo(xPos);
-  yAxis.moveTo(yPos);
-  // Use bitwise OR to ensure both run() calls execute
-  while (xAxis.distanceToGo() != 0 || yAxis.distanceToGo() != 0) {
-    xAxis.run();
-    yAxis.run();
+  // Later moves continue from where the axes actually are
+  curX = planner.getPosition(0);
+  curY = planner.getPosition(1);
+  if (commandCount == 0) {
+    lineX = curX;
+    lineY = curY;
   }
 }
 
-void Linear(int xPos, int yPos) {
-  long t[] = {xPos, yPos};
-  cnc.moveTo(t);
-  cnc.runSpeedToPosition();
-  //while () {
-  //  Serial.println("Moving in a linear fashion");
-  //}
+// Rapid move: queued like a linear move but at the rapid velocity.
+void Rapid(long xPos, long yPos) {
+  while (planner.isFull()) {
+    RunPlanner();
+  }
+  planner.addLine(xPos, yPos, velocity);
 }
 
-static void processGCodeLine(const String &line) {
-  GCodeParser::Command cmd = GCodeParser::parseLine(line);
-  if (!cmd.valid) {
-    Serial.print(F("ERR: "));
-    Serial.println(cmd.error);
-    return;
+// Steps for a value already accepted by checkRange()
+static long toSteps(const GCodeParser::Fixed &v) {
+  long steps = 0;
+  GCodeParser::toSteps(v, CNC_STEPS_PER_UNIT, steps);
+  return steps;
+}
+
+// A line whose coordinates or feed do not fit in steps is rejected before it is queued.
+static GCodeParser::Error checkRange(const GCodeParser::Command &cmd) {
+  long steps;
+  GCodeParser::Error err = GCodeParser::ERR_NONE;
+  if (cmd.hasX && (err = GCodeParser::toSteps(cmd.x, CNC_STEPS_PER_UNIT, steps)) != GCodeParser::ERR_NONE) return err;
+  if (cmd.hasY && (err = GCodeParser::toSteps(cmd.y, CNC_STEPS_PER_UNIT, steps)) != GCodeParser::ERR_NONE) return err;
+  if (cmd.hasF && (err = GCodeParser::toSteps(cmd.f, CNC_STEPS_PER_UNIT, steps)) != GCodeParser::ERR_NONE) return err;
+  return GCodeParser::ERR_NONE;
+}
+
+// End point of a G0-G3 move from (x0, y0); a missing axis keeps its position.
+static void moveTarget(const GCodeParser::Command &cmd, long x0, long y0, long &x, long &y) {
+  x = cmd.hasX ? toSteps(cmd.x) : x0;
+  y = cmd.hasY ? toSteps(cmd.y) : y0;
+}
+
+// Center offset (steps) of a G2/G3 arc from (x0, y0) to (x1, y1). Returns false if the
+// end point is not on the circle.
+static bool arcCenter(const GCodeParser::Command &cmd, long x0, long y0, long x1, long y1, float &i, float &j) {
+  if (cmd.hasR) {
+    bool clockwise = (cmd.type == GCodeParser::TYPE_G2);
+    float r = GCodeParser::toDouble(cmd.r) * CNC_STEPS_PER_UNIT;
+    return ArcSegmenter::centerFromRadius(x0, y0, x1, y1, r, clockwise, i, j);
   }
+  i = GCodeParser::toDouble(cmd.i) * CNC_STEPS_PER_UNIT;
+  j = GCodeParser::toDouble(cmd.j) * CNC_STEPS_PER_UNIT;
+  return ArcSegmenter::onCircle(x0, y0, x1, y1, i, j);
+}
 
+// A G1/G2/G3 F word sets the feed for this and later moves.
+static void applyFeed(const GCodeParser::Command &cmd) {
+  if (cmd.hasF) {
+    long feed = toSteps(cmd.f);
+    feedRate = min(feed, (long)maxFeed);
+  }
+}
+
+static void executeCommand(const GCodeParser::Command &cmd) {
   switch (cmd.type) {
     case GCodeParser::TYPE_G28: {
-      Serial.println(F("CMD: G28 (Home)"));
+      if (verbose) Serial.println(F("CMD: G28 (Home)"));
       Home();
-      curX = 0;
-      curY = 0;
       break;
     }
     case GCodeParser::TYPE_G0: {
       long tx = curX;
       long ty = curY;
-      if (cmd.hasX) tx = (long)(cmd.x + 0.5); // Round to nearest integer
-      if (cmd.hasY) ty = (long)(cmd.y + 0.5); // Round to nearest integer
-      Serial.print(F("CMD: G0 X")); Serial.print(tx); Serial.print(F(" Y")); Serial.println(ty);
+      if (cmd.hasX) tx = toSteps(cmd.x);
+      if (cmd.hasY) ty = toSteps(cmd.y);
+      if (verbose) { Serial.print(F("CMD: G0 X")); Serial.print(tx); Serial.print(F(" Y")); Serial.println(ty); }
       Rapid(tx, ty);
-      // Update current position from actual stepper positions
-      curX = xAxis.currentPosition();
-      curY = yAxis.currentPosition();
-      Serial.print(F("Pos: X")); Serial.print(curX); Serial.print(F(" Y")); Serial.println(curY);
+      // Track the planned (not yet reached) position
+      curX = tx;
+      curY = ty;
       break;
     }
     case GCodeParser::TYPE_G1: {
       long tx = curX;
       long ty = curY;
-      if (cmd.hasX) tx = (long)(cmd.x + 0.5); // Round to nearest integer
-      if (cmd.hasY) ty = (long)(cmd.y + 0.5); // Round to nearest integer
-      if (cmd.hasF) {
-        xAxis.setMaxSpeed((float)cmd.f);
-        yAxis.setMaxSpeed((float)cmd.f);
+      if (cmd.hasX) tx = toSteps(cmd.x);
+      if (cmd.hasY) ty = toSteps(cmd.y);
+      applyFeed(cmd);
+      if (verbose) { Serial.print(F("CMD: G1 X")); Serial.print(tx); Serial.print(F(" Y")); Serial.println(ty); }
+      planner.addLine(tx, ty, feedRate);
+      // Track the planned (not yet reached) position
+      curX = tx;
+      curY = ty;
+      break;
+    }
+    case GCodeParser::TYPE_G2:
+    case GCodeParser::TYPE_G3: {
+      long tx, ty;
+      moveTarget(cmd, curX, curY, tx, ty);
+      bool clockwise = (cmd.type == GCodeParser::TYPE_G2);
+      // The line was checked and acknowledged when it arrived; this only fails if a
+      // failed homing left the axes somewhere else since. The arc is dropped.
+      float i, j;
+      if (!arcCenter(cmd, curX, curY, tx, ty, i, j) || !arc.begin(curX, curY, tx, ty, i, j, clockwise)) {
+        reportAlarm(GCodeParser::errorMessage(GCodeParser::ERR_ARC_END_POINT));
+        break;
       }
-      Serial.print(F("CMD: G1 X")); Serial.print(tx); Serial.print(F(" Y")); Serial.println(ty);
-      Linear(tx, ty);
-      // Update current position from actual stepper positions
-      curX = xAxis.currentPosition();
-      curY = yAxis.currentPosition();
-      Serial.print(F("Pos: X")); Serial.print(curX); Serial.print(F(" Y")); Serial.println(curY);
+      applyFeed(cmd);
+      if (verbose) {
+        Serial.print(clockwise ? F("CMD: G2 X") : F("CMD: G3 X"));
+        Serial.print(tx); Serial.print(F(" Y")); Serial.print(ty);
+        Serial.print(F(" segments ")); Serial.println(arc.segmentCount());
+      }
+      // Track the planned (not yet reached) position
+      curX = tx;
+      curY = ty;
       break;
     }
     case GCodeParser::TYPE_M3: {
-      Serial.print(F("CMD: M3"));
-      if (cmd.hasS) { Serial.print(F(" S")); Serial.print(cmd.s); }
-      Serial.println();
+      if (verbose) {
+        Serial.print(F("CMD: M3"));
+        if (cmd.hasS) { Serial.print(F(" S")); Serial.print(cmd.s); }
+        Serial.println();
+      }
       // TODO: hook spindle control if available
       break;
     }
     default:
-      Serial.println(F("ERR: Unsupported/unknown command type"));
+      // Already acknowledged: the parser only accepts the types above
+      reportAlarm(F("Unsupported/unknown command type"));
       break;
   }
 }
 
-void setup() {
-  Serial.begin(9600);
-  delay(200);
-  Serial.println(F("CNC Controller Ready"));
-  pinMode(xMin, INPUT_PULLUP);
-  pinMode(yMin, INPUT_PULLUP);
-  xAxis.setMaxSpeed(velocity);
-  xAxis.setAcceleration(accel); 
-  yAxis.setMaxSpeed(velocity);
-  yAxis.setAcceleration(accel);
-  Home();
-  cnc.addStepper(xAxis);
-  cnc.addStepper(yAxis);
-  
+// Move queued commands into the planner while it has room.
+static void executeQueuedCommands() {
+  for (;;) {
+    // An arc in progress goes in segment by segment, ahead of any later command
+    long sx, sy;
+    while (arc.isActive()) {
+      if (planner.isFull()) return;
+      arc.next(sx, sy);
+      planner.addLine(sx, sy, feedRate);
+    }
+    if (commandCount == 0 || homing.isActive()) return;
+    const GCodeParser::Command &cmd = commandQueue[commandTail];
+    bool isMove = (cmd.type == GCodeParser::TYPE_G0 || cmd.type == GCodeParser::TYPE_G1 ||
+                   cmd.type == GCodeParser::TYPE_G2 || cmd.type == GCodeParser::TYPE_G3);
+    if (isMove && planner.isFull()) return;
+    executeCommand(cmd);
+    commandTail = (commandTail + 1) % COMMAND_QUEUE_SIZE;
+    commandCount--;
+  }
 }
 
-void loop() {
-  // Read incoming serial data line-by-line
-  while (Serial.available() > 0) {
+// Parse a complete line into the command queue and acknowledge it (once: OK or ERR).
+static void processGCodeLine(const char *line, uint8_t length) {
+  if (verbose) {
+    Serial.print(F(">> "));
+    Serial.println(line);
+  }
+  GCodeParser::Command &cmd = commandQueue[commandHead];
+  cmd = GCodeParser::parseLine(line, length);
+  if (cmd.valid && (cmd.error = checkRange(cmd)) != GCodeParser::ERR_NONE) cmd.valid = false;
+  long tx = lineX, ty = lineY;
+  bool isArc = (cmd.type == GCodeParser::TYPE_G2 || cmd.type == GCodeParser::TYPE_G3);
+  if (cmd.valid && (cmd.type == GCodeParser::TYPE_G0 || cmd.type == GCodeParser::TYPE_G1 || isArc)) {
+    moveTarget(cmd, lineX, lineY, tx, ty);
+    float i, j;
+    if (isArc && !arcCenter(cmd, lineX, lineY, tx, ty, i, j)) {
+      cmd.valid = false;
+      cmd.error = GCodeParser::ERR_ARC_END_POINT;
+    }
+  } else if (cmd.valid && cmd.type == GCodeParser::TYPE_G28) {
+    tx = 0; // homing makes the switches the origin
+    ty = 0;
+  }
+  if (!cmd.valid) {
+    Serial.print(F("ERR: "));
+    Serial.println(GCodeParser::errorMessage(cmd.error));
+    return;
+  }
+  lineX = tx;
+  lineY = ty;
+  commandHead = (commandHead + 1) % COMMAND_QUEUE_SIZE;
+  commandCount++;
+  Serial.println(F("OK")); // Line consumed; the host may send more
+}
+
+// Read serial input into the line buffer. Stops reading while the command queue is
+// full so unacknowledged bytes stay in the serial RX buffer.
+static void readSerial() {
+  while (commandCount < COMMAND_QUEUE_SIZE && Serial.available() > 0) {
     char c = (char)Serial.read();
     if (c == '\r') continue; // ignore CR
     if (c == '\n') {
-      inputLine.trim();
-      if (inputLine.length() > 0) {
-        Serial.print(F(">> "));
-        Serial.println(inputLine);
-        processGCodeLine(inputLine);
-        Serial.println(F("OK")); // Send OK after completing command
-      }
-      inputLine = "";
-    } else {
-      // Only add printable characters
-      if (c >= 32 && c <= 126) {
-        inputLine += c;
-      }
-      if (inputLine.length() > 120) {
+      // trim surrounding whitespace
+      uint8_t start = 0;
+      while (start < inputLength && inputLine[start] == ' ') start++;
+      while (inputLength > start && inputLine[inputLength - 1] == ' ') inputLength--;
+      inputLine[inputLength] = '\0';
+      if (inputOverflow) {
         Serial.println(F("ERR: Line too long"));
-        inputLine = "";
+      } else if (inputLength > start) {
+        processGCodeLine(inputLine + start, inputLength - start);
+      } else {
+        Serial.println(F("OK")); // blank line: nothing to do, but the host counted it
+      }
+      inputLength = 0;
+      inputOverflow = false;
+    } else if (c >= 32 && c <= 126) {
+      // Only add printable characters; an overlong line is dropped up to its newline
+      if (inputLength < LINE_MAX_LENGTH) {
+        inputLine[inputLength++] = c;
+      } else {
+        inputOverflow = true;
       }
     }
   }
 }
+
+void setup() {
+  Serial.begin(CNC_BAUD);
+  delay(200);
+#if GCODE_BENCH
+  GCodeBench::run(Serial);
+  while (true) {
+    delay(1000);
+  }
+#endif
+  Serial.println(F("CNC Controller Ready"));
+  pinMode(xMin, INPUT_PULLUP);
+  pinMode(yMin, INPUT_PULLUP);
+  engine.begin();
+  engine.setLimitPins(xMin, yMin);
+  engine.setMinSpeed(sqrt(2.0 * accel)); // speed reached one step after starting from rest
+  planner.setAcceleration(accel);
+  planner.setJunctionDeviation(junctionDeviation);
+  arc.setTolerance(arcTolerance);
+  homing.setSpeeds(homeSeek, homeReseek);
+  homing.setBackoff(homeBackoff);
+  Home();
+  // Advertise the receive buffer size for character-counting hosts
+  Serial.print(F("RX:"));
+  Serial.println(SERIAL_RX_BUFFER_SIZE);
+}
+
+void loop() {
+  // Keep the queued moves running, feed the planner, then take new input
+  RunPlanner();
+  RunHoming();
+  executeQueuedCommands();
+  readSerial();
+}
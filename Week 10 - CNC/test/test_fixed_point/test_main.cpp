@@ -0,0 +1,146 @@
+// test_fixed_point
+// Host tests for the fixed point number path (pio test -e native): parseLine() plus
+// GCodeParser::toSteps() against the float path it replaced (strtod, scale, round half
+// away from zero), over rounding, negative values, exponents and the range of a long.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "GCodeParser.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// X value of "G1 X<text>" through the fixed point path
+static GCodeParser::Error fixedSteps(const char* text, long stepsPerUnit, long& steps) {
+    char line[64];
+    snprintf(line, sizeof(line), "G1 X%s", text);
+    GCodeParser::Command cmd = GCodeParser::parseLine(line);
+    if (!cmd.valid) return cmd.error;
+    TEST_ASSERT_TRUE(cmd.hasX);
+    return GCodeParser::toSteps(cmd.x, stepsPerUnit, steps);
+}
+
+// The float path: strtod, scale, round half away from zero (long double keeps the
+// product exact enough for every value used here)
+static long floatSteps(const char* text, long stepsPerUnit) {
+    return (long)llroundl(strtold(text, NULL) * (long double)stepsPerUnit);
+}
+
+static void checkSame(const char* text, long stepsPerUnit) {
+    long steps = 0;
+    char msg[80];
+    snprintf(msg, sizeof(msg), "X%s at %ld steps/unit", text, stepsPerUnit);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(GCodeParser::ERR_NONE, fixedSteps(text, stepsPerUnit, steps), msg);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(floatSteps(text, stepsPerUnit), steps, msg);
+}
+
+void test_rounding_matches_float(void) {
+    const char* values[] = {"0", "0.4", "0.5", "0.6", "1.499999", "1.5", "2.5", "12.345678",
+                            "0.000001", "0.0000005", "999.9995", "100.25"};
+    const long scales[] = {1, 2, 4, 80, 400, 1000};
+    for (unsigned i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        for (unsigned s = 0; s < sizeof(scales) / sizeof(scales[0]); s++) checkSame(values[i], scales[s]);
+    }
+}
+
+void test_negative_values_round_away_from_zero(void) {
+    const char* values[] = {"-0.4", "-0.5", "-0.6", "-1.5", "-2.5", "-12.345678", "-0.000001", "-100.25"};
+    const long scales[] = {1, 3, 80, 1000};
+    for (unsigned i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        for (unsigned s = 0; s < sizeof(scales) / sizeof(scales[0]); s++) checkSame(values[i], scales[s]);
+    }
+    long steps = 0;
+    fixedSteps("-2.5", 1, steps);
+    TEST_ASSERT_EQUAL_INT32(-3, steps); // the old (long)(x + 0.5) gave -2
+}
+
+void test_exponents_match_float(void) {
+    const char* values[] = {"1e3", "1.5e3", "1.5E+3", "-2.5e-1", "125e-3", "-125e-3", "3e-7",
+                            "4.75e2", "1e9", "0.0001e4", "12345678e-6"};
+    const long scales[] = {1, 8, 250};
+    for (unsigned i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        for (unsigned s = 0; s < sizeof(scales) / sizeof(scales[0]); s++) checkSame(values[i], scales[s]);
+    }
+}
+
+void test_random_values_match_float(void) {
+    // Up to six decimals, so the float path sees the same value the fixed point path keeps
+    srand(12345);
+    char text[32];
+    for (int n = 0; n < 20000; n++) {
+        long whole = rand() % 2000000 - 1000000;
+        long micro = rand() % 1000000;
+        long scale = 1 + rand() % 1000;
+        snprintf(text, sizeof(text), "%s%ld.%06ld", (whole < 0 || (whole == 0 && (n & 1))) ? "-" : "",
+                 labs(whole), micro);
+        checkSame(text, scale);
+    }
+}
+
+void test_seventh_decimal_rounds_into_sixth(void) {
+    // The fixed point path keeps six decimals, so these differ from the float path on purpose
+    long steps = 0;
+    TEST_ASSERT_EQUAL_INT(GCodeParser::ERR_NONE, fixedSteps("0.4999995", 1, steps));
+    TEST_ASSERT_EQUAL_INT32(1, steps); // 0.500000
+    TEST_ASSERT_EQUAL_INT(GCodeParser::ERR_NONE, fixedSteps("-0.4999995", 1, steps));
+    TEST_ASSERT_EQUAL_INT32(-1, steps);
+    TEST_ASSERT_EQUAL_INT(GCodeParser::ERR_NONE, fixedSteps("0.4999994", 1, steps));
+    TEST_ASSERT_EQUAL_INT32(0, steps);
+}
+
+void test_overflow_boundary(void) {
+    // At the largest scale the boundary is within the parser's int32 range on every target
+    const long scale = FIXED_MAX_STEPS_PER_UNIT;
+    const long limit = LONG_MAX / scale;
+    const long slack = LONG_MAX - limit * scale; // steps left for the fraction
+    char text[32];
+    long steps = 0;
+
+    snprintf(text, sizeof(text), "%ld", limit);
+    TEST_ASSERT_EQUAL_INT(GCodeParser::ERR_NONE, fixedSteps(text, scale, steps));
+    TEST_ASSERT_TRUE(steps == limit * scale);
+    snprintf(text, sizeof(text), "-%ld", limit);
+    TEST_ASSERT_EQUAL_INT(GCodeParser::ERR_NONE, fixedSteps(text, scale, steps));
+    TEST_ASSERT_TRUE(steps == -limit * scale);
+
+    snprintf(text, sizeof(text), "%ld", limit + 1);
+    steps = 7;
+    TEST_ASSERT_EQUAL_INT(GCodeParser::ERR_NUMBER_OUT_OF_RANGE, fixedSteps(text, scale, steps));
+    TEST_ASSERT_EQUAL_INT32(7, steps); // left alone on error
+    snprintf(text, sizeof(text), "-%ld", limit + 1);
+    TEST_ASSERT_EQUAL_INT(GCodeParser::ERR_NUMBER_OUT_OF_RANGE, fixedSteps(text, scale, steps));
+
+    // With a fraction it overflows exactly when the rounded fraction exceeds the slack
+    const long micros[] = {1, 250000, 500000, 999999};
+    for (unsigned i = 0; i < sizeof(micros) / sizeof(micros[0]); i++) {
+        long fraction = (long)llroundl((long double)micros[i] * scale / FIXED_ONE);
+        snprintf(text, sizeof(text), "%ld.%06ld", limit, micros[i]);
+        GCodeParser::Error expected = fraction > slack ? GCodeParser::ERR_NUMBER_OUT_OF_RANGE : GCodeParser::ERR_NONE;
+        TEST_ASSERT_EQUAL_INT_MESSAGE(expected, fixedSteps(text, scale, steps), text);
+        if (expected == GCodeParser::ERR_NONE) TEST_ASSERT_TRUE(steps == limit * scale + fraction);
+        snprintf(text, sizeof(text), "-%ld.%06ld", limit, micros[i]);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(expected, fixedSteps(text, scale, steps), text);
+        if (expected == GCodeParser::ERR_NONE) TEST_ASSERT_TRUE(steps == -limit * scale - fraction);
+    }
+
+    // The whole int32 range converts at one step per unit
+    TEST_ASSERT_EQUAL_INT(GCodeParser::ERR_NONE, fixedSteps("2147483647", 1, steps));
+    TEST_ASSERT_TRUE(steps == 2147483647L);
+    TEST_ASSERT_EQUAL_INT(GCodeParser::ERR_NONE, fixedSteps("-2147483647", 1, steps));
+    TEST_ASSERT_TRUE(steps == -2147483647L);
+    TEST_ASSERT_EQUAL_INT(GCodeParser::ERR_NUMBER_OUT_OF_RANGE, fixedSteps("2147483648", 1, steps));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_rounding_matches_float);
+    RUN_TEST(test_negative_values_round_away_from_zero);
+    RUN_TEST(test_exponents_match_float);
+    RUN_TEST(test_random_values_match_float);
+    RUN_TEST(test_seventh_decimal_rounds_into_sixth);
+    RUN_TEST(test_overflow_boundary);
+    return UNITY_END();
+}
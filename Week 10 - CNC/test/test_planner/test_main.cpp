@@ -0,0 +1,180 @@
+// test_planner
+// Host tests for Planner (pio test -e native): feeds block sequences and checks the
+// planned speed profile against the junction and acceleration limits, and that the
+// executing block is never re-planned.
+
+#include <Arduino.h>
+#include <unity.h>
+#include "Planner.h"
+
+static const float ACCEL = 800.0f;
+static const float DEVIATION = 2.0f;
+
+static Planner planner;
+
+void setUp(void) {
+    planner = Planner();
+    planner.setAcceleration(ACCEL);
+    planner.setJunctionDeviation(DEVIATION);
+}
+
+void tearDown(void) {}
+
+// Tolerance for comparing squared speeds computed in float
+static float slack(float v2) { return 1e-3f * v2 + 1e-3f; }
+
+// Junction limit (squared) between two moves, computed independently of the planner
+static float junctionLimitSqr(float ux0, float uy0, float v0, float ux1, float uy1, float v1) {
+    float limit = v0 < v1 ? v0 * v0 : v1 * v1;
+    float cosTheta = -(ux0 * ux1 + uy0 * uy1);
+    if (cosTheta > 0.999999f) return 0.0f;
+    if (cosTheta < -0.999999f) return limit;
+    float s = sqrtf(0.5f * (1.0f - cosTheta));
+    float v2 = ACCEL * DEVIATION * s / (1.0f - s);
+    return v2 < limit ? v2 : limit;
+}
+
+struct Move {
+    long x, y;
+    float feed;
+};
+
+// Block `i` in the queue. The planner starts at slot 0, so after `discarded` blocks the
+// oldest one sits in slot discarded % PLANNER_BUFFER_SIZE.
+static Planner::Block* queued(int discarded, uint8_t i) {
+    Planner::Block* buffer = planner.currentBlock() - discarded % PLANNER_BUFFER_SIZE;
+    return buffer + (discarded + i) % PLANNER_BUFFER_SIZE;
+}
+
+// Every queued block: entry within its junction limit and reachable from both sides
+static void checkQueue(const Move* moves, int first, long startX, long startY) {
+    TEST_ASSERT_TRUE(planner.currentBlock() != NULL);
+    long px = startX, py = startY;
+    float pux = 0.0f, puy = 0.0f, pfeed = 0.0f;
+    if (first > 0) {
+        long ppx = first > 1 ? moves[first - 2].x : 0;
+        long ppy = first > 1 ? moves[first - 2].y : 0;
+        float dx = (float)(moves[first - 1].x - ppx), dy = (float)(moves[first - 1].y - ppy);
+        float len = sqrtf(dx * dx + dy * dy);
+        pux = dx / len;
+        puy = dy / len;
+        pfeed = moves[first - 1].feed;
+    }
+
+    for (uint8_t i = 0; i < planner.count(); i++) {
+        const Planner::Block* b = queued(first, i);
+        const Move& m = moves[first + i];
+        TEST_ASSERT_EQUAL_INT32(m.x, b->target[0]);
+        TEST_ASSERT_EQUAL_INT32(m.y, b->target[1]);
+
+        float dx = (float)(m.x - px), dy = (float)(m.y - py);
+        float len = sqrtf(dx * dx + dy * dy);
+        float ux = dx / len, uy = dy / len;
+
+        float limit = (first + i == 0) ? 0.0f : junctionLimitSqr(pux, puy, pfeed, ux, uy, m.feed);
+        TEST_ASSERT_FLOAT_WITHIN(slack(limit), limit, b->maxEntrySpeedSqr);
+        TEST_ASSERT_TRUE(b->entrySpeedSqr <= b->maxEntrySpeedSqr + slack(b->maxEntrySpeedSqr));
+
+        // Accelerating and decelerating over the block both fit in its length
+        float entry = b->entrySpeedSqr;
+        float exit = planner.exitSpeedSqr(b);
+        float budget = 2.0f * b->acceleration * b->length;
+        TEST_ASSERT_TRUE(entry - exit <= budget + slack(budget));
+        TEST_ASSERT_TRUE(exit - entry <= budget + slack(budget));
+
+        px = m.x;
+        py = m.y;
+        pux = ux;
+        puy = uy;
+        pfeed = m.feed;
+    }
+}
+
+static void feedAndCheck(const Move* moves, int n) {
+    int first = 0;
+    long sx = 0, sy = 0;
+    for (int i = 0; i < n; i++) {
+        if (planner.isFull()) {
+            checkQueue(moves, first, sx, sy);
+            Planner::Block* b = planner.currentBlock();
+            sx = b->target[0];
+            sy = b->target[1];
+            planner.discardCurrentBlock();
+            first++;
+        }
+        TEST_ASSERT_TRUE(planner.addLine(moves[i].x, moves[i].y, moves[i].feed));
+        checkQueue(moves, first, sx, sy);
+    }
+    while (!planner.isEmpty()) {
+        checkQueue(moves, first, sx, sy);
+        Planner::Block* b = planner.currentBlock();
+        sx = b->target[0];
+        sy = b->target[1];
+        planner.discardCurrentBlock();
+        first++;
+    }
+}
+
+void test_straight_line_blends_to_nominal(void) {
+    const Move moves[] = {{100, 0, 400}, {200, 0, 400}, {300, 0, 400}, {400, 0, 400}};
+    feedAndCheck(moves, 4);
+}
+
+void test_corners_and_reversal(void) {
+    const Move moves[] = {
+        {400, 0, 1000}, {400, 400, 1000}, {800, 500, 600}, {0, 500, 1200},  // 90 deg, shallow, reversal
+        {10, 505, 1200}, {20, 500, 1200}, {30, 505, 1200}, {2000, 500, 300}, // zig-zag, long slow
+    };
+    feedAndCheck(moves, 8);
+}
+
+void test_short_blocks_limit_by_acceleration(void) {
+    // Blocks too short to reach feed: entries are bounded by 2*a*d, not the feed
+    Move moves[24];
+    for (int i = 0; i < 24; i++) {
+        moves[i].x = (i + 1) * 3;
+        moves[i].y = (i % 2) ? 1 : 0;
+        moves[i].feed = 5000.0f;
+    }
+    feedAndCheck(moves, 24);
+}
+
+void test_executing_block_is_not_replanned(void) {
+    planner.addLine(200, 0, 800);
+    planner.addLine(400, 0, 800);
+    Planner::Block* running = planner.currentBlock();
+    float entry = running->entrySpeedSqr;
+
+    // More look-ahead would raise the speeds if the running block were still plannable
+    planner.addLine(600, 0, 800);
+    planner.addLine(800, 0, 800);
+    TEST_ASSERT_FLOAT_WITHIN(0.0f, entry, running->entrySpeedSqr);
+
+    // After it is discarded the machine is at the speed it left with: frozen too
+    float nextEntry = planner.exitSpeedSqr(running);
+    planner.discardCurrentBlock();
+    Planner::Block* next = planner.currentBlock();
+    float frozen = next->entrySpeedSqr;
+    TEST_ASSERT_FLOAT_WITHIN(slack(nextEntry), nextEntry, frozen);
+    planner.addLine(1000, 0, 800);
+    planner.addLine(1200, 0, 800);
+    TEST_ASSERT_FLOAT_WITHIN(0.0f, frozen, next->entrySpeedSqr);
+}
+
+void test_first_block_after_idle_starts_from_rest(void) {
+    planner.addLine(500, 0, 1000);
+    TEST_ASSERT_FLOAT_WITHIN(0.0f, 0.0f, planner.currentBlock()->entrySpeedSqr);
+    planner.discardCurrentBlock();
+    planner.addLine(1000, 0, 1000);
+    TEST_ASSERT_FLOAT_WITHIN(0.0f, 0.0f, planner.currentBlock()->entrySpeedSqr);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_straight_line_blends_to_nominal);
+    RUN_TEST(test_corners_and_reversal);
+    RUN_TEST(test_short_blocks_limit_by_acceleration);
+    RUN_TEST(test_executing_block_is_not_replanned);
+    RUN_TEST(test_first_block_after_idle_starts_from_rest);
+    return UNITY_END();
+}
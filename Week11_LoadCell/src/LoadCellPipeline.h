@@ -0,0 +1,184 @@
+#ifndef LOAD_CELL_PIPELINE_H
+#define LOAD_CELL_PIPELINE_H
+
+// LoadCellPipeline.h
+// Acquisition pipeline for the NAU7802 load cell amplifier.
+//
+// Reading: update() is called from every loop() pass and never waits. With a DRDY pin the
+// conversion-ready interrupt sets a flag; without one the ADC is only polled over I2C
+// once a conversion is due (one sample period after the last one), so loop() is not
+// spent on I2C polls that cannot succeed.
+//
+// Filtering, all in integer arithmetic on raw counts (zero offset removed):
+//  1. median of the last `median` samples (1 = off): removes single-sample spikes
+//  2. moving average over `average` samples (1 = off): running sum, O(1) per sample
+//  3. single-pole IIR, y += (x - y) / 2^shift (0 = off): extra smoothing for a slow display
+//
+// Decimation: one output per `decimation` filtered samples. At 320 SPS with a 16-sample
+// average and decimation 16, each output averages 50 ms of conversions and the weight
+// settles within one output, against the 100 ms per raw sample at 10 SPS.
+
+#include <Arduino.h>
+#include "SparkFun_Qwiic_Scale_NAU7802_Arduino_Library.h"
+
+#ifndef LOADCELL_MAX_MEDIAN
+#define LOADCELL_MAX_MEDIAN 7
+#endif
+
+#ifndef LOADCELL_MAX_AVERAGE
+#define LOADCELL_MAX_AVERAGE 32
+#endif
+
+class LoadCellPipeline {
+public:
+    explicit LoadCellPipeline(NAU7802& adc)
+        : _adc(adc), _periodUs(3125), _lastSample(0), _median(1), _average(1), _iirShift(0),
+          _decimation(1), _countSpan(1), _gramSpan(1), _drdyPin(-1)
+    {
+        reset();
+    }
+
+    // Conversion period of the rate set on the NAU7802 (e.g. NAU7802_SPS_320)
+    void setSampleRate(uint8_t rate) {
+        switch (rate) {
+            case NAU7802_SPS_20: _periodUs = 50000; break;
+            case NAU7802_SPS_40: _periodUs = 25000; break;
+            case NAU7802_SPS_80: _periodUs = 12500; break;
+            case NAU7802_SPS_320: _periodUs = 3125; break;
+            default: _periodUs = 100000; break;
+        }
+    }
+
+    // Filter chain; each stage is skipped at 1 (median, average) or 0 (iirShift)
+    void setFilter(uint8_t median, uint8_t average, uint8_t iirShift) {
+        _median = constrain(median, 1, LOADCELL_MAX_MEDIAN);
+        _average = constrain(average, 1, LOADCELL_MAX_AVERAGE);
+        _iirShift = iirShift > 16 ? 16 : iirShift;
+        reset();
+    }
+    void setDecimation(uint8_t n) { _decimation = n ? n : 1; }
+
+    // Calibration: `countSpan` counts correspond to `gramSpan` grams
+    void setScale(long countSpan, long gramSpan) {
+        _countSpan = countSpan ? countSpan : 1;
+        _gramSpan = gramSpan;
+    }
+
+    // Use the NAU7802 DRDY output on an interrupt-capable pin instead of I2C polling
+    void useDataReadyPin(uint8_t pin) {
+        _drdyPin = pin;
+        pinMode(pin, INPUT);
+        dataReady() = false;
+        attachInterrupt(digitalPinToInterrupt(pin), _drdyIsr, RISING);
+    }
+
+    // Clear the filter history (e.g. after tare)
+    void reset() {
+        _medianCount = 0;
+        _medianHead = 0;
+        _averageCount = 0;
+        _averageHead = 0;
+        _averageSum = 0;
+        _iirValid = false;
+        _iir = 0;
+        _sinceOutput = 0;
+        _value = 0;
+        _samples = 0;
+    }
+
+    // Take a conversion if one is ready. Returns true when a new decimated output is ready.
+    bool update() {
+        unsigned long now = micros();
+        if (_drdyPin >= 0) {
+            if (!dataReady()) return false;
+            dataReady() = false;
+        } else {
+            if ((now - _lastSample) < _periodUs) return false; // not due yet: no I2C traffic
+            if (!_adc.available()) return false;
+        }
+        _lastSample = now;
+        int32_t raw = _adc.getReading() - _adc.getZeroOffset();
+        _samples++;
+        int32_t filtered = _filter(raw);
+        if (++_sinceOutput < _decimation) return false;
+        _sinceOutput = 0;
+        _value = filtered;
+        return true;
+    }
+
+    // Last output in counts and in milligrams
+    int32_t counts() const { return _value; }
+    int32_t milligrams() const { return toMilligrams(_value); }
+    int32_t toMilligrams(int32_t counts) const {
+        return (int32_t)((int64_t)counts * _gramSpan * 1000 / _countSpan);
+    }
+    unsigned long samples() const { return _samples; }
+
+private:
+    NAU7802& _adc;
+    unsigned long _periodUs;
+    unsigned long _lastSample;
+    uint8_t _median;
+    uint8_t _average;
+    uint8_t _iirShift;
+    uint8_t _decimation;
+    long _countSpan;
+    long _gramSpan;
+    int _drdyPin;
+
+    int32_t _medianBuf[LOADCELL_MAX_MEDIAN];
+    uint8_t _medianCount;
+    uint8_t _medianHead;
+    int32_t _averageBuf[LOADCELL_MAX_AVERAGE];
+    uint8_t _averageCount;
+    uint8_t _averageHead;
+    int32_t _averageSum;   // 24-bit samples: 32 of them still fit
+    bool _iirValid;
+    int64_t _iir;          // IIR state, scaled by 2^_iirShift
+    uint8_t _sinceOutput;
+    int32_t _value;
+    unsigned long _samples;
+
+    static volatile bool& dataReady() {
+        static volatile bool ready = false;
+        return ready;
+    }
+    static void _drdyIsr() { dataReady() = true; }
+
+    int32_t _filter(int32_t x) {
+        if (_median > 1) {
+            _medianBuf[_medianHead] = x;
+            _medianHead = (_medianHead + 1) % _median;
+            if (_medianCount < _median) _medianCount++;
+            // Insertion sort of a copy; at most LOADCELL_MAX_MEDIAN entries
+            int32_t sorted[LOADCELL_MAX_MEDIAN];
+            for (uint8_t i = 0; i < _medianCount; i++) {
+                int32_t v = _medianBuf[i];
+                uint8_t j = i;
+                while (j > 0 && sorted[j - 1] > v) { sorted[j] = sorted[j - 1]; j--; }
+                sorted[j] = v;
+            }
+            x = sorted[_medianCount / 2];
+        }
+        if (_average > 1) {
+            if (_averageCount == _average) _averageSum -= _averageBuf[_averageHead];
+            else _averageCount++;
+            _averageBuf[_averageHead] = x;
+            _averageHead = (_averageHead + 1) % _average;
+            _averageSum += x;
+            x = _averageSum / _averageCount;
+        }
+        if (_iirShift) {
+            if (!_iirValid) {
+                _iir = (int64_t)x << _iirShift;
+                _iirValid = true;
+            } else {
+                _iir += x - (_iir >> _iirShift);
+            }
+            x = (int32_t)(_iir >> _iirShift);
+        }
+        return x;
+    }
+};
+
+#endif // LOAD_CELL_PIPELINE_H
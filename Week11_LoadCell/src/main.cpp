@@ -1,43 +1,52 @@
 #include <Arduino.h> 
 #include <Wire.h>
 #include "SparkFun_Qwiic_Scale_NAU7802_Arduino_Library.h"
+#include "LoadCellPipeline.h"
 
 NAU7802 loadcell;
+LoadCellPipeline scale(loadcell);
 
-int sampleRate = 10;
+uint8_t sampleRate = NAU7802_SPS_320;
 int minVal = 161000;
 int minMass = -400;
 int maxVal = -167000;
 int maxMass = 400;
 int zeroVal = -8000;
 
-int readingToGrams(long val) {
-  return float(maxMass - minMass) / float(maxVal - minVal) * val;
-}
+// Filter chain: 3-sample median, 16-sample average, no IIR; one output per 16 samples (20/s)
+uint8_t medianLength = 3;
+uint8_t averageLength = 16;
+uint8_t iirShift = 0;
+uint8_t decimation = 16;
 
 void setup() { 
   delay(1000);
-  Serial.begin(9600);
+  Serial.begin(115200);
   Wire.begin();
   while(!loadcell.begin()) {
     Serial.println("Waiting for load cell to start");
     delay(100);
   }
   loadcell.setSampleRate(sampleRate);
-  loadcell.setGain(128);
+  loadcell.setGain(NAU7802_GAIN_128);
   loadcell.calibrateAFE();
   delay(500);
   loadcell.calculateZeroOffset(50); 
+
+  scale.setSampleRate(sampleRate);
+  scale.setFilter(medianLength, averageLength, iirShift);
+  scale.setDecimation(decimation);
+  scale.setScale(maxVal - minVal, maxMass - minMass);
 }
 
 void loop() { 
-  if(loadcell.available()) {
-    int32_t lcReading = loadcell.getReading() - loadcell.getZeroOffset();
-    Serial.print(lcReading);
-    Serial.print(" means g = ");
-    Serial.print(readingToGrams(lcReading));
-    Serial.print(" at time ");
-    Serial.println(millis());
+  if (scale.update()) {
+    // One line per output, integer formatting only
+    int32_t mg = scale.milligrams();
+    char line[48];
+    int len = snprintf(line, sizeof(line), "%ld means g = %s%ld.%02ld at time %lu\r\n",
+                       (long)scale.counts(), mg < 0 ? "-" : "", labs(mg) / 1000, (labs(mg) % 1000) / 10,
+                       millis());
+    Serial.write((const uint8_t*)line, len < (int)sizeof(line) ? len : sizeof(line) - 1);
   }
-  delay(1000/sampleRate);
-} 
\ No newline at end of file
+}
@@ -0,0 +1,102 @@
+#ifndef OLED_RENDERER_H
+#define OLED_RENDERER_H
+
+// OledRenderer.h
+// Text-line renderer for the SSD1306 Qwiic OLEDs that only redraws what changed.
+//
+// Each line keeps the text it last drew. print() compares the new text with it and, only
+// if it differs, clears the old text's cells and draws the new one into the library's
+// framebuffer, growing a dirty rectangle. flush() skips display() when the rectangle is
+// empty; otherwise the driver sends only the columns drawn on each page, so a changed
+// digit costs a few dozen bytes instead of a whole frame.
+//
+// Numbers are formatted from integer tenths (formatTenths()), so the UI needs no float
+// printf.
+
+#include <Arduino.h>
+#include <string.h>
+
+#ifndef OLED_LINE_CHARS
+#define OLED_LINE_CHARS 16
+#endif
+
+// "<label><value/10>.<value%10>" into out, e.g. formatTenths(buf, 16, "Tc: ", 215) -> "Tc: 21.5"
+inline void formatTenths(char* out, size_t size, const char* label, long tenths) {
+    unsigned int a = (unsigned int)(tenths < 0 ? -tenths : tenths);
+    snprintf(out, size, "%s%s%u.%u", label, tenths < 0 ? "-" : "", a / 10, a % 10);
+}
+
+template <class Oled, uint8_t LINES>
+class OledRenderer {
+public:
+    explicit OledRenderer(Oled& oled) : _oled(oled) {
+        for (uint8_t i = 0; i < LINES; i++) {
+            _lines[i].x = 0;
+            _lines[i].y = 0;
+            _lines[i].text[0] = '\0';
+        }
+        _clean();
+    }
+
+    // Position of line i (top-left corner of its first character)
+    void setLine(uint8_t i, uint8_t x, uint8_t y) {
+        _lines[i].x = x;
+        _lines[i].y = y;
+    }
+
+    // Show `text` on line i; draws only if it differs from what the line shows
+    void print(uint8_t i, const char* text) {
+        Line& l = _lines[i];
+        if (strncmp(l.text, text, OLED_LINE_CHARS) == 0) return;
+        const QwiicFont* font = _oled.getFont();
+        uint8_t cell = font->width + 1;
+        size_t oldLen = strlen(l.text);
+        strncpy(l.text, text, OLED_LINE_CHARS);
+        l.text[OLED_LINE_CHARS] = '\0';
+        size_t newLen = strlen(l.text);
+        size_t len = oldLen > newLen ? oldLen : newLen;
+        uint8_t w = (uint8_t)min((size_t)(_oled.getWidth() - l.x), len * cell);
+        _oled.rectangleFill(l.x, l.y, w, font->height, COLOR_BLACK);
+        _oled.text(l.x, l.y, l.text);
+        _mark(l.x, l.y, l.x + w, l.y + font->height);
+    }
+
+    // Blank every line (e.g. when the screen changes to another state)
+    void clear() {
+        for (uint8_t i = 0; i < LINES; i++) print(i, "");
+    }
+
+    // Send the dirty area to the panel. Returns true if anything was sent.
+    bool flush() {
+        if (_x1 <= _x0 || _y1 <= _y0) return false;
+        // The SSD1306 driver tracks the drawn range of each page and only sends that
+        _oled.display();
+        _clean();
+        return true;
+    }
+
+private:
+    struct Line {
+        uint8_t x, y;
+        char text[OLED_LINE_CHARS + 1];
+    };
+
+    Oled& _oled;
+    Line _lines[LINES];
+    uint8_t _x0, _y0, _x1, _y1; // dirty rectangle, [x0, x1) x [y0, y1)
+
+    void _clean() {
+        _x0 = 255;
+        _y0 = 255;
+        _x1 = 0;
+        _y1 = 0;
+    }
+    void _mark(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1) {
+        if (x0 < _x0) _x0 = x0;
+        if (y0 < _y0) _y0 = y0;
+        if (x1 > _x1) _x1 = x1;
+        if (y1 > _y1) _y1 = y1;
+    }
+};
+
+#endif // OLED_RENDERER_H
@@ -0,0 +1,106 @@
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+// TaskScheduler.h
+// Cooperative scheduler run from loop() on millis() deadlines.
+//
+// Each task has a period. run() calls every task whose deadline has passed and moves its
+// deadline on by one period, so a task keeps its rate even when a call runs late. A task
+// that fell a whole period behind is restarted from now and counted as late, instead of
+// being called several times in a row to catch up.
+//
+// Every call is timed with micros(); report() prints calls, mean and worst execution time
+// and late starts per task, for tuning the periods.
+
+#include <Arduino.h>
+
+#ifndef SCHEDULER_MAX_TASKS
+#define SCHEDULER_MAX_TASKS 8
+#endif
+
+class TaskScheduler {
+public:
+    typedef void (*TaskFn)(void);
+
+    TaskScheduler() : _count(0) {}
+
+    // Add a task; returns its id, or -1 when the table is full
+    int8_t add(const char* name, TaskFn fn, unsigned long periodMs) {
+        if (_count >= SCHEDULER_MAX_TASKS) return -1;
+        Task& t = _tasks[_count];
+        t.name = name;
+        t.fn = fn;
+        t.period = periodMs;
+        t.next = millis();
+        _clearStats(t);
+        return (int8_t)_count++;
+    }
+
+    void setPeriod(int8_t id, unsigned long periodMs) { _tasks[id].period = periodMs; }
+    unsigned long getPeriod(int8_t id) const { return _tasks[id].period; }
+
+    // Call from loop(): runs every task that is due
+    void run() {
+        for (uint8_t i = 0; i < _count; i++) {
+            Task& t = _tasks[i];
+            unsigned long now = millis();
+            if ((long)(now - t.next) < 0) continue;
+            t.next += t.period;
+            if ((long)(now - t.next) >= 0) {
+                t.late++;
+                t.next = now + t.period;
+            }
+            unsigned long start = micros();
+            t.fn();
+            unsigned long us = micros() - start;
+            t.calls++;
+            t.totalUs += us;
+            if (us > t.maxUs) t.maxUs = us;
+        }
+    }
+
+    void report(Print& out) const {
+        for (uint8_t i = 0; i < _count; i++) {
+            const Task& t = _tasks[i];
+            out.print(t.name);
+            out.print(" period=");
+            out.print(t.period);
+            out.print("ms calls=");
+            out.print(t.calls);
+            out.print(" mean=");
+            out.print(t.calls ? (unsigned long)(t.totalUs / t.calls) : 0UL);
+            out.print("us max=");
+            out.print(t.maxUs);
+            out.print("us late=");
+            out.println(t.late);
+        }
+    }
+
+    void resetStats() {
+        for (uint8_t i = 0; i < _count; i++) _clearStats(_tasks[i]);
+    }
+
+private:
+    struct Task {
+        const char* name;
+        TaskFn fn;
+        unsigned long period;
+        unsigned long next;    // millis() deadline
+        unsigned long calls;
+        unsigned long late;
+        unsigned long maxUs;
+        uint64_t totalUs;
+    };
+
+    Task _tasks[SCHEDULER_MAX_TASKS];
+    uint8_t _count;
+
+    static void _clearStats(Task& t) {
+        t.calls = 0;
+        t.late = 0;
+        t.maxUs = 0;
+        t.totalUs = 0;
+    }
+};
+
+#endif // TASK_SCHEDULER_H
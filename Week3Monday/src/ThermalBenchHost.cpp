@@ -0,0 +1,135 @@
+// ThermalBenchHost.cpp
+// Host-side thermostat benchmark (env:native_bench). Runs ThermostatControl against a
+// simulated room for two hours of model time, once per mode, and reports rise time,
+// overshoot, steady-state ripple, relay switching and the execution time of step().
+//
+//   pio run -e native_bench && .pio/build/native_bench/program
+//
+// Room model: the heater element warms with a 60 s lag, the room follows the element
+// with a 600 s time constant (20 C above ambient at full power), and the sensor lags the
+// room by 20 s and reads in 0.01 C steps with a little noise. The target steps from 20 C
+// to 22 C after one hour.
+//
+// The whole file is compiled out unless THERMAL_BENCH_HOST is defined, so the board
+// environments are unaffected.
+
+#if defined(THERMAL_BENCH_HOST)
+
+#include <Arduino.h>
+#include "ThermostatControl.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#define BENCH_PERIOD_MS 250
+#define BENCH_SECONDS 7200
+#define BENCH_AMBIENT 15.0
+#define BENCH_HEATER_RISE 20.0
+
+struct RoomModel {
+    double element; // heater element output, 0..1
+    double room;    // C
+    double sensor;  // C
+    uint32_t noise;
+
+    void reset() {
+        element = 0.0;
+        room = BENCH_AMBIENT;
+        sensor = BENCH_AMBIENT;
+        noise = 1;
+    }
+    void advance(bool heaterOn, double dt) {
+        element += ((heaterOn ? 1.0 : 0.0) - element) * dt / 60.0;
+        room += (BENCH_AMBIENT + BENCH_HEATER_RISE * element - room) * dt / 600.0;
+        sensor += (room - sensor) * dt / 20.0;
+    }
+    int32_t measure() {
+        noise = noise * 1103515245u + 12345u;
+        int jitter = (int)((noise >> 16) % 5) - 2; // +-0.02 C
+        return (int32_t)lround(sensor * 100.0) + jitter;
+    }
+};
+
+struct BenchResult {
+    double riseSeconds;    // first time within 0.2 C of the first target
+    double overshoot;      // worst room temperature above target after reaching it
+    double ripple;         // room peak-to-peak over the last 20 minutes
+    unsigned long switches;
+    double stepNsMean;
+    double stepNsMax;
+};
+
+static BenchResult runBench(ThermostatControl::Mode mode) {
+    const uint8_t heaterPin = 13;
+    ThermostatControl control(heaterPin, BENCH_PERIOD_MS);
+    control.begin();
+    control.setMode(mode);
+    control.setHysteresis(25);
+    control.setGains(400, 1, 1000);
+    control.setWindow(40);
+
+    RoomModel model;
+    model.reset();
+    BenchResult r = {-1.0, 0.0, 0.0, 0, 0.0, 0.0};
+    double lowest = 1e9, highest = -1e9;
+    bool lastHeater = false;
+    double totalNs = 0.0;
+    unsigned long steps = BENCH_SECONDS * 1000UL / BENCH_PERIOD_MS;
+    const double dt = BENCH_PERIOD_MS / 1000.0;
+
+    for (unsigned long i = 0; i < steps; i++) {
+        double t = i * dt;
+        int32_t target = t < 3600.0 ? 2000 : 2200;
+        control.setTarget(target);
+
+        int32_t measured = model.measure();
+        auto t0 = std::chrono::steady_clock::now();
+        control.step(measured);
+        auto t1 = std::chrono::steady_clock::now();
+        double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+        totalNs += ns;
+        r.stepNsMax = std::max(r.stepNsMax, ns);
+
+        bool heater = control.heaterOn();
+        if (heater != lastHeater) r.switches++;
+        lastHeater = heater;
+        // Integrate the model over the period in 50 ms steps
+        for (int k = 0; k < BENCH_PERIOD_MS / 50; k++) model.advance(heater, 0.05);
+
+        double targetC = target / 100.0;
+        if (r.riseSeconds < 0.0 && t < 3600.0 && fabs(model.room - targetC) < 0.2) r.riseSeconds = t;
+        if (r.riseSeconds >= 0.0) r.overshoot = std::max(r.overshoot, model.room - targetC);
+        if (t >= BENCH_SECONDS - 1200.0) {
+            lowest = std::min(lowest, model.room);
+            highest = std::max(highest, model.room);
+        }
+    }
+    r.ripple = highest - lowest;
+    r.stepNsMean = totalNs / steps;
+    return r;
+}
+
+// The HAL's main() is disabled for this environment; these satisfy its declarations.
+void setup() {}
+void loop() {}
+
+int main() {
+    const struct {
+        ThermostatControl::Mode mode;
+        const char* name;
+    } modes[] = {
+        {ThermostatControl::MODE_HYSTERESIS, "hysteresis"},
+        {ThermostatControl::MODE_PID, "pid"},
+    };
+    printf("THERMAL_BENCH host: %d s, period %d ms, target 20 C then 22 C at 3600 s\n", BENCH_SECONDS, BENCH_PERIOD_MS);
+    printf("%-11s %8s %10s %8s %9s %14s\n", "mode", "rise s", "overshoot", "ripple", "switches", "step ns mean/max");
+    for (const auto& m : modes) {
+        BenchResult r = runBench(m.mode);
+        printf("%-11s %8.0f %9.2fC %7.2fC %9lu %8.0f / %.0f\n", m.name, r.riseSeconds, r.overshoot, r.ripple,
+               r.switches, r.stepNsMean, r.stepNsMax);
+    }
+    return 0;
+}
+
+#endif // THERMAL_BENCH_HOST
@@ -0,0 +1,150 @@
+#ifndef THERMOSTAT_CONTROL_H
+#define THERMOSTAT_CONTROL_H
+
+// ThermostatControl.h
+// Heater control for the thermostat, stepped at a fixed period.
+//
+// All temperatures are integer hundredths of a degree C and the controller output is a
+// duty cycle in permille (0..1000). Two modes:
+//  - MODE_HYSTERESIS: heater on below target - band, off above target + band.
+//  - MODE_PID: fixed-point PID. The derivative acts on the measurement, so changing the
+//    target does not kick the output, and is low-pass filtered against sensor noise.
+//    Anti-windup: the integral only grows while the output is not saturated in the
+//    direction of the error, and is clamped to the output range.
+//    The relay is time-proportioned: in every window of `window` steps it is on for
+//    output * window / 1000 steps.
+//
+// step() takes a measurement and updates the heater pin; call it from a timer at the
+// period given to the constructor, not from the UI loop.
+
+#include <Arduino.h>
+
+class ThermostatControl {
+public:
+    enum Mode {
+        MODE_OFF = 0,
+        MODE_HYSTERESIS,
+        MODE_PID
+    };
+
+    ThermostatControl(uint8_t heaterPin, unsigned long periodMs)
+        : _pin(heaterPin), _periodMs(periodMs ? periodMs : 1), _mode(MODE_OFF), _target(2000),
+          _band(25), _kp(400), _ki(1), _kd(1000), _window(40), _windowStep(0), _integral(0),
+          _dFiltered(0), _prevMeasured(0), _havePrev(false), _output(0), _heater(false) {}
+
+    void begin() {
+        pinMode(_pin, OUTPUT);
+        _heater = false;
+        digitalWrite(_pin, LOW);
+    }
+
+    void setMode(Mode mode) {
+        if (mode == _mode) return;
+        _mode = mode;
+        reset();
+    }
+    Mode getMode() const { return (Mode)_mode; }
+
+    void setTarget(int32_t centiC) { _target = centiC; }
+    int32_t getTarget() const { return _target; }
+
+    // Hysteresis half band (hundredths of a degree)
+    void setHysteresis(int32_t centiC) { _band = centiC < 0 ? -centiC : centiC; }
+
+    // PID gains: kp in permille per degree, ki in permille per degree-second,
+    // kd in permille per degree/second
+    void setGains(int32_t kp, int32_t ki, int32_t kd) {
+        _kp = kp;
+        _ki = ki;
+        _kd = kd;
+    }
+
+    // Length of the relay's time-proportioning window, in steps
+    void setWindow(uint16_t steps) { _window = steps ? steps : 1; }
+
+    // Forget the integral and derivative history
+    void reset() {
+        _integral = 0;
+        _dFiltered = 0;
+        _havePrev = false;
+        _windowStep = 0;
+        _output = 0;
+        _write(false);
+    }
+
+    // One control period with a new measurement
+    void step(int32_t measuredCentiC) {
+        int32_t error = _target - measuredCentiC;
+        switch (_mode) {
+        case MODE_HYSTERESIS:
+            if (error > _band) _output = 1000;
+            else if (error < -_band) _output = 0;
+            _write(_output > 0);
+            break;
+        case MODE_PID: {
+            // Proportional and derivative parts in permille
+            int32_t p = (int32_t)((int64_t)_kp * error / 100);
+            int32_t d = 0;
+            if (_havePrev && _kd) {
+                // kd * -d(measured)/dt, with dt = period; filtered y += (x - y) / 4
+                int32_t raw = (int32_t)(-(int64_t)_kd * (measuredCentiC - _prevMeasured) * 1000 / (100L * (long)_periodMs));
+                _dFiltered += (raw - _dFiltered) / 4;
+                d = _dFiltered;
+            }
+            _prevMeasured = measuredCentiC;
+            _havePrev = true;
+
+            // Integral kept in permille * 1000 for resolution at small errors
+            int64_t di = (int64_t)_ki * error * (long)_periodMs / 100;
+            int32_t unclamped = p + (int32_t)((_integral + di) / 1000) + d;
+            bool saturatedHigh = unclamped > 1000 && error > 0;
+            bool saturatedLow = unclamped < 0 && error < 0;
+            if (!saturatedHigh && !saturatedLow) _integral += di;
+            if (_integral > 1000000) _integral = 1000000;
+            if (_integral < 0) _integral = 0;
+
+            int32_t u = p + (int32_t)(_integral / 1000) + d;
+            _output = (uint16_t)constrain(u, 0, 1000);
+
+            // Time-proportioned relay
+            uint32_t onSteps = (uint32_t)_output * _window / 1000;
+            _write(_windowStep < onSteps);
+            if (++_windowStep >= _window) _windowStep = 0;
+            break;
+        }
+        default:
+            _output = 0;
+            _write(false);
+            break;
+        }
+    }
+
+    uint16_t output() const { return _output; }
+    bool heaterOn() const { return _heater; }
+    unsigned long periodMs() const { return _periodMs; }
+
+private:
+    uint8_t _pin;
+    unsigned long _periodMs;
+    uint8_t _mode;
+    int32_t _target;
+    int32_t _band;
+    int32_t _kp, _ki, _kd;
+    uint16_t _window;
+    uint16_t _windowStep;
+    int64_t _integral;     // permille * 1000
+    int32_t _dFiltered;    // permille
+    int32_t _prevMeasured;
+    bool _havePrev;
+    uint16_t _output;      // permille
+    bool _heater;
+
+    // The pin is only written when the relay state changes
+    void _write(bool on) {
+        if (on == _heater) return;
+        _heater = on;
+        digitalWrite(_pin, on ? HIGH : LOW);
+    }
+};
+
+#endif // THERMOSTAT_CONTROL_H
@@ -75,6 +75,10 @@
 
 // Include the SparkFun qwiic OLED Library
 #include <SparkFun_Qwiic_OLED.h>
+#include "OledRenderer.h"
+#include "TaskScheduler.h"
+#include "ThermostatControl.h"
+#include "ButtonInput.h"
 
 #define SEALEVELPRESSURE_HPA (1013.25)
 
@@ -94,15 +98,24 @@ const char * deviceName = "Micro OLED";
 
 #endif
 
+// Two text lines; only changed text is redrawn and sent to the panel
+OledRenderer<decltype(myOLED), 2> screen(myOLED);
+
 int yoffset;
 float targetTemperature = 20.0;
 char degreeSys[] = "C";
 int pinButton = 10;
 int pinUp = 11;
 int pinDown = 12;
-bool prevPressed = false;
-bool prevUp = false;
-bool prevDown = false;
+int pinHeater = 13;
+
+// The buttons are sampled and debounced from a timer every buttonSampleMs; scanButtons()
+// only reads the press events. A long press on the mode button goes back to the
+// temperature display.
+unsigned long buttonSampleMs = 5;
+unsigned long longPressTime = 800;
+ButtonInput buttons;
+int8_t modeButton, upButton, downButton;
 
 enum MachineStates {
     DisplayTemps, // 0
@@ -112,6 +125,60 @@ enum MachineStates {
 
 MachineStates currentState;
 
+// Task periods (ms). The BME280 is sampled by the control tick, far below the loop rate,
+// and the UI reads the cached value; button events are picked up within one period.
+unsigned long controlPeriod = 250;
+unsigned long buttonPeriod = 10;
+unsigned long renderPeriod = 50;
+unsigned long reportPeriod = 10000;
+
+TaskScheduler scheduler;
+
+// Heater relay on pinHeater. The control tick runs from a timer (a FreeRTOS task on the
+// ESP32), so a slow UI pass never delays it.
+ThermostatControl control(pinHeater, controlPeriod);
+ThermostatControl::Mode controlMode = ThermostatControl::MODE_PID;
+unsigned long controlMaxUs = 0;
+
+// Last temperature sample. The control tick writes it from its task (or timer) while the
+// UI reads it from loop(), so both sides copy it, and controlMaxUs, only under the lock.
+struct TemperatureCache {
+    float celsius;
+    unsigned long at; // millis() of the sample
+    bool valid;
+};
+TemperatureCache tempCache = {0.0f, 0, false};
+
+#if defined(ESP32) && !defined(NATIVE_HAL)
+portMUX_TYPE tempMux = portMUX_INITIALIZER_UNLOCKED;
+inline void lockTemperature() { portENTER_CRITICAL(&tempMux); }
+inline void unlockTemperature() { portEXIT_CRITICAL(&tempMux); }
+#else
+inline void lockTemperature() { noInterrupts(); }
+inline void unlockTemperature() { interrupts(); }
+#endif
+
+TemperatureCache readTemperatureCache()
+{
+    lockTemperature();
+    TemperatureCache t = tempCache;
+    unlockTemperature();
+    return t;
+}
+
+void sampleTemperature();
+void controlTick();
+#if defined(ESP32) && !defined(NATIVE_HAL)
+void controlTask(void*);
+#endif
+void buttonSample();
+#if defined(ESP32) && !defined(NATIVE_HAL)
+void buttonTask(void*);
+#endif
+void scanButtons();
+void render();
+void report();
+
 ////////////////////////////////////////////////////////////////////////////////////////////////
 // setup()
 // 
@@ -123,6 +190,9 @@ void setup()
     pinMode(pinButton, INPUT_PULLDOWN);
     pinMode(pinUp, INPUT_PULLDOWN);
     pinMode(pinDown, INPUT_PULLDOWN);
+    modeButton = buttons.add(pinButton, true, 0, longPressTime);
+    upButton = buttons.add(pinUp, true);
+    downButton = buttons.add(pinDown, true);
 
     Serial.begin(9600);
     delay(3000);
@@ -146,8 +216,27 @@ void setup()
     }
 
     yoffset = (myOLED.getHeight() - myOLED.getFont()->height)/2;
+    screen.setLine(0, 3, yoffset);
+    screen.setLine(1, 3, yoffset + 12);
 
     delay(1000);
+
+    control.begin();
+    control.setMode(controlMode);
+    control.setTarget(lroundf(targetTemperature * 100));
+#if defined(NATIVE_HAL)
+    hal::every(controlPeriod * 1000UL, controlTick);
+    hal::every(buttonSampleMs * 1000UL, buttonSample);
+#elif defined(ESP32)
+    xTaskCreate(controlTask, "control", 4096, NULL, 2, NULL);
+    xTaskCreate(buttonTask, "sample", 2048, NULL, 3, NULL);
+#else
+    scheduler.add("control", controlTick, controlPeriod);
+    scheduler.add("sample", buttonSample, buttonSampleMs);
+#endif
+    scheduler.add("buttons", scanButtons, buttonPeriod);
+    scheduler.add("render", render, renderPeriod);
+    scheduler.add("report", report, reportPeriod);
 }
 
 // Our testing functions
@@ -222,49 +311,134 @@ static const testRoutine testFunctions[] = {
 
 
 float cToF(float degC) {
-    return (degC +32.0) * 9.0 / 5.0;
+    return degC * 9.0 / 5.0 + 32.0;
 }
 
+// Tenths of a degree in the selected system
+long displayTenths(float degC) {
+    return lroundf((degreeSys[0] == 'F' ? cToF(degC) : degC) * 10);
+}
 
-void loop()
+
+// The I2C read stays outside the lock; only the copy into the cache is inside
+void sampleTemperature()
 {
-    if(digitalRead(pinButton) && !prevPressed) {
-        currentState = MachineStates(((int)currentState + 1) % 3);
+    TemperatureCache t = {bme.readTemperature(), millis(), true};
+    lockTemperature();
+    tempCache = t;
+    unlockTemperature();
+}
+
+// One control period: fresh sample, then the heater output
+void controlTick()
+{
+    unsigned long start = micros();
+    sampleTemperature();
+    control.step(lroundf(readTemperatureCache().celsius * 100));
+    unsigned long us = micros() - start;
+    lockTemperature();
+    if (us > controlMaxUs) controlMaxUs = us;
+    unlockTemperature();
+}
+
+#if defined(ESP32) && !defined(NATIVE_HAL)
+// Fixed-rate control task; Wire serialises the BME280 and OLED transactions
+void controlTask(void*)
+{
+    TickType_t wake = xTaskGetTickCount();
+    for (;;) {
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(controlPeriod));
+        controlTick();
     }
+}
+#endif
 
-    
-    prevPressed = digitalRead(pinButton);
+void buttonSample()
+{
+    buttons.sample();
+}
 
-    char myNewText[50];
-    if (currentState == DisplayTemps) {
-        float temp = bme.readTemperature();
-        
-        sprintf(myNewText, "Tc: %.1f ", temp );
-        myOLED.erase();
-        myOLED.text(3, yoffset, myNewText);
-
-        sprintf(myNewText, "Ttar: %.1f", targetTemperature);
-        myOLED.text(3, yoffset + 12, myNewText);
-        myOLED.display(); 
-    } else if (currentState == SetTemp) {
-        if (digitalRead(pinUp) && !prevUp) {
-            targetTemperature++; // targetTemperature += 1.0; // targetTemperature = targerTempreature + 1.0;
+#if defined(ESP32) && !defined(NATIVE_HAL)
+void buttonTask(void*)
+{
+    TickType_t wake = xTaskGetTickCount();
+    for (;;) {
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(buttonSampleMs));
+        buttonSample();
+    }
+}
+#endif
+
+void scanButtons()
+{
+    ButtonEvent e;
+    while (buttons.read(e)) {
+        if (e.button == modeButton) {
+            if (e.type == BUTTON_LONG) currentState = DisplayTemps;
+            else currentState = MachineStates(((int)currentState + 1) % 3);
+        } else if (currentState == SetTemp) {
+            if (e.button == upButton) {
+                targetTemperature++; // targetTemperature += 1.0; // targetTemperature = targerTempreature + 1.0;
+            } else if (e.button == downButton) {
+                targetTemperature--;
+            }
+            control.setTarget(lroundf(targetTemperature * 100));
+        } else if (currentState == ChooseSystem) {
+            degreeSys[0] = (degreeSys[0] == 'C') ? 'F' : 'C';
         }
-        if (digitalRead(pinDown) && !prevDown) {
-            targetTemperature--;
+    }
+}
+
+void render()
+{
+    char myNewText[24]; // longer text is cut to OLED_LINE_CHARS by the renderer
+    if (currentState == DisplayTemps) {
+        TemperatureCache t = readTemperatureCache();
+        if (t.valid) {
+            formatTenths(myNewText, sizeof(myNewText), "Tc: ", displayTenths(t.celsius));
+        } else {
+            strcpy(myNewText, "Tc: --");
         }
-        prevUp = digitalRead(pinUp);
-        prevDown = digitalRead(pinDown);
-        sprintf(myNewText, "Ttar: %.1f", targetTemperature);
-        myOLED.erase();
-        myOLED.text(3, yoffset, myNewText);
-        myOLED.display(); 
+        screen.print(0, myNewText);
+
+        formatTenths(myNewText, sizeof(myNewText), "Ttar: ", displayTenths(targetTemperature));
+        screen.print(1, myNewText);
+    } else if (currentState == SetTemp) {
+        formatTenths(myNewText, sizeof(myNewText), "Ttar: ", displayTenths(targetTemperature));
+        screen.print(0, myNewText);
+        screen.print(1, "");
     } else if (currentState == ChooseSystem) {
-        sprintf(myNewText, "System: %s", degreeSys); 
-        myOLED.erase();
-        myOLED.text(3, yoffset, myNewText);
-        myOLED.display(); 
+        snprintf(myNewText, sizeof(myNewText), "System: %s", degreeSys); 
+        screen.print(0, myNewText);
+        screen.print(1, "");
     }
+    screen.flush();
+}
 
-    
-}
\ No newline at end of file
+// Per-task execution times for tuning the periods
+void report()
+{
+    lockTemperature();
+    TemperatureCache t = tempCache;
+    unsigned long maxUs = controlMaxUs;
+    unlockTemperature();
+
+    Serial.print("T=");
+    Serial.print(t.celsius, 2);
+    Serial.print(" C, ");
+    Serial.print(millis() - t.at);
+    Serial.println(" ms old");
+    Serial.print("heater ");
+    Serial.print(control.heaterOn() ? "on" : "off");
+    Serial.print(" output=");
+    Serial.print(control.output());
+    Serial.print("/1000 control max=");
+    Serial.print(maxUs);
+    Serial.println("us");
+    scheduler.report(Serial);
+}
+
+void loop()
+{
+    scheduler.run();
+}
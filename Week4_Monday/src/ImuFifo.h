@@ -0,0 +1,193 @@
+#ifndef IMU_FIFO_H
+#define IMU_FIFO_H
+
+// ImuFifo.h
+// BMI270 acquisition through its FIFO instead of one getSensorData() per frame.
+//
+// The BMI270 queues one accel+gyro frame per ODR period. drain() reads everything queued
+// in bursts of up to IMU_FIFO_BURST frames and pushes each frame, timestamped, into a
+// lock-free ring that the consumer empties with read(). drain() runs in the sensor task,
+// read() in loop(); a slow frame no longer loses samples, it only delays them.
+//
+// With useInterruptPin() the FIFO watermark interrupt (INT1) marks when `watermark`
+// frames are queued and drain() does no I2C until then, apart from a poll after two
+// watermark periods in case an edge was missed. Without it drain() reads the FIFO
+// length and only bursts once the watermark is reached.
+//
+// Timestamps (micros()) are reconstructed from the ODR: the frame that reached the
+// watermark is placed at the interrupt time (or, when polling, the newest frame at the
+// time the length was read) and the others one ODR period apart. When polling they are
+// late by up to one period.
+//
+// Counters: dropped() frames found the ring full (consumer too slow); overflows()
+// counts bursts that found the FIFO full, where the BMI270 has overwritten older
+// frames.
+
+#include <Arduino.h>
+#include "SparkFun_BMI270_Arduino_Library.h"
+#include "SpscRing.h"
+
+#ifndef IMU_FIFO_BURST
+#define IMU_FIFO_BURST 16
+#endif
+
+#ifndef IMU_RING_SIZE
+#define IMU_RING_SIZE 64
+#endif
+
+// BMI270 FIFO: 2 KB of 13-byte accel+gyro frames with header
+#ifndef IMU_FIFO_CAPACITY
+#define IMU_FIFO_CAPACITY 157
+#endif
+
+struct ImuSample {
+    unsigned long timestamp; // micros()
+    float ax, ay, az;        // g
+    float gx, gy, gz;        // deg/s
+};
+
+class ImuFifo {
+public:
+    explicit ImuFifo(BMI270& imu)
+        : _imu(imu), _periodUs(5000), _watermark(8), _intPin(-1), _lastDrain(0), _samples(0),
+          _dropped(0), _overflows(0), _bursts(0) {}
+
+    // Set the accel and gyro ODR (BMI2_ACC_ODR_xxx, same code for both) and start the
+    // FIFO with a watermark of `watermark` frames
+    int8_t begin(uint8_t odr, uint16_t watermark) {
+        _periodUs = _odrPeriodUs(odr);
+        _watermark = constrain(watermark, 1, IMU_FIFO_CAPACITY);
+        int8_t err = _imu.setAccelODR(odr);
+        if (err == BMI2_OK) err = _imu.setGyroODR(odr);
+        if (err != BMI2_OK) return err;
+
+        BMI270_FIFOConfig config;
+        config.flags = BMI2_FIFO_ACC_EN | BMI2_FIFO_GYR_EN;
+        config.watermark = _watermark;
+        config.accelDownSample = 0;
+        config.gyroDownSample = 0;
+        config.accelFilter = BMI2_ENABLE;
+        config.gyroFilter = BMI2_ENABLE;
+        config.selfWakeUp = BMI2_ENABLE;
+        err = _imu.setFIFOConfig(config);
+        _lastDrain = micros();
+        return err;
+    }
+
+    // Route the watermark interrupt to INT1, wired to `pin`
+    int8_t useInterruptPin(uint8_t pin) {
+        bmi2_int_pin_config intConfig;
+        intConfig.pin_type = BMI2_INT1;
+        intConfig.int_latch = BMI2_INT_NON_LATCH;
+        intConfig.pin_cfg[0].lvl = BMI2_INT_ACTIVE_HIGH;
+        intConfig.pin_cfg[0].od = BMI2_INT_PUSH_PULL;
+        intConfig.pin_cfg[0].output_en = BMI2_INT_OUTPUT_ENABLE;
+        intConfig.pin_cfg[0].input_en = BMI2_INT_INPUT_DISABLE;
+        int8_t err = _imu.setInterruptPinConfig(intConfig);
+        if (err == BMI2_OK) err = _imu.mapInterruptToPin(BMI2_FWM_INT, BMI2_INT1);
+        if (err != BMI2_OK) return err;
+        _intPin = pin;
+        pinMode(pin, INPUT);
+        _isrFlag() = false;
+        attachInterrupt(digitalPinToInterrupt(pin), _watermarkIsr, RISING);
+        return BMI2_OK;
+    }
+
+    // Producer: move queued frames into the ring. Returns the number of frames read.
+    uint16_t drain() {
+        unsigned long now = micros();
+        unsigned long anchor = now;
+        bool fromIsr = false;
+        if (_intPin >= 0) {
+            if (_isrFlag()) {
+                noInterrupts();
+                anchor = _isrTime();
+                _isrFlag() = false;
+                interrupts();
+                fromIsr = true;
+            } else if ((now - _lastDrain) < 2UL * _watermark * _periodUs) {
+                return 0; // watermark not reached: no I2C traffic
+            }
+        }
+
+        uint16_t queued = 0;
+        if (_imu.getFIFOLength(&queued) != BMI2_OK) return 0;
+        if (_intPin < 0 && queued < _watermark) return 0;
+        if (queued == 0) return 0;
+        if (queued >= IMU_FIFO_CAPACITY) {
+            // Frames were overwritten, including the one the interrupt marked
+            _overflows++;
+            fromIsr = false;
+            anchor = now;
+        }
+        _lastDrain = now;
+        _bursts++;
+
+        // Frame `ref` (0-based, in read order) was taken at `anchor`
+        uint16_t ref = fromIsr ? _watermark - 1 : queued - 1;
+        uint16_t index = 0;
+        while (index < queued) {
+            uint16_t n = queued - index;
+            if (n > IMU_FIFO_BURST) n = IMU_FIFO_BURST;
+            if (_imu.getFIFOData(_burst, &n) != BMI2_OK || n == 0) break;
+            for (uint16_t i = 0; i < n; i++, index++) {
+                const BMI270_SensorData& d = _burst[i];
+                ImuSample s;
+                s.timestamp = anchor + ((long)index - (long)ref) * (long)_periodUs;
+                s.ax = d.accelX;
+                s.ay = d.accelY;
+                s.az = d.accelZ;
+                s.gx = d.gyroX;
+                s.gy = d.gyroY;
+                s.gz = d.gyroZ;
+                if (!_ring.push(s)) _dropped++;
+            }
+            _samples += n;
+        }
+        return index;
+    }
+
+    // Consumer: oldest frame not yet read
+    bool read(ImuSample& out) { return _ring.pop(out); }
+    uint16_t pending() const { return _ring.count(); }
+
+    unsigned long periodMicros() const { return _periodUs; }
+    unsigned long samples() const { return _samples; }
+    unsigned long dropped() const { return _dropped; }
+    unsigned long overflows() const { return _overflows; }
+    unsigned long bursts() const { return _bursts; }
+
+private:
+    BMI270& _imu;
+    unsigned long _periodUs;
+    uint16_t _watermark;
+    int _intPin;
+    unsigned long _lastDrain;
+    unsigned long _samples;
+    unsigned long _dropped;
+    unsigned long _overflows;
+    unsigned long _bursts;
+    BMI270_SensorData _burst[IMU_FIFO_BURST];
+    SpscRing<ImuSample, IMU_RING_SIZE> _ring;
+
+    static unsigned long _odrPeriodUs(uint8_t odr) {
+        // 0x08 is 100 Hz; every step up doubles the rate
+        if (odr >= 8) return 10000UL >> (odr - 8);
+        return 10000UL << (8 - odr);
+    }
+
+    static volatile bool& _isrFlag() {
+        static volatile bool flag = false;
+        return flag;
+    }
+    static volatile unsigned long& _isrTime() {
+        static volatile unsigned long at = 0;
+        return at;
+    }
+    static void _watermarkIsr() {
+        _isrTime() = micros();
+        _isrFlag() = true;
+    }
+};
+
+#endif // IMU_FIFO_H
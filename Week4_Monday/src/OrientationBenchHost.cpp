@@ -0,0 +1,274 @@
+// OrientationBenchHost.cpp
+// Host-side check of OrientationFilter against IMU traces (env:native_bench). For each
+// trace it runs the fused estimate and the old per-frame accelerometer tilt side by side
+// and reports their angle error against the true attitude, the sample-to-sample jitter
+// and the execution time of update().
+//
+//   pio run -e native_bench && .pio/build/native_bench/program [trace.csv]
+//
+// Without an argument three synthetic 60 s traces at 200 Hz are generated, with known
+// attitude: a still tilted board on a vibrating bench (0.5 g at 47 Hz), a board swaying
+// on all three axes with the same vibration, and a still board with a 2 deg/s gyro bias.
+// All traces add white noise. A recorded trace is a CSV with one sample per line,
+//   t_ms,ax,ay,az,gx,gy,gz        (g and deg/s, as in BMI270::data)
+// optionally followed by the true X and Y angles; without them only jitter and the
+// fused/accelerometer difference are reported. A line
+//   # limits rms max min_gated max_gated
+// anywhere in the file gives the trace pass limits like the synthetic ones below, and
+// the program then exits with 1 if the trace is over them.
+//
+// No recorded BMI270 trace is checked in yet, so the limits only cover the synthetic
+// traces. A recording needs reference angles from a fixture (a known tilt or a rotary
+// stage), not from this filter, before it can carry limits of its own.
+//
+// The synthetic traces also have pass limits on the fused RMS and max tilt error, about
+// twice what the filter reaches today, and on the share of accelerometer samples the
+// gate skips: most of them on the vibrating traces, where the error bound only holds
+// because shaken samples are gated, and none on the still one. A trace over its limits
+// prints FAIL and the program exits with 1, so a regression fails the native run.
+//
+// The whole file is compiled out unless ORIENTATION_BENCH_HOST is defined, so the board
+// environments are unaffected.
+
+#if defined(ORIENTATION_BENCH_HOST)
+
+#include <Arduino.h>
+#include "OrientationFilter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#define BENCH_RATE_HZ 200
+#define BENCH_SECONDS 60
+#define BENCH_SETTLE_SECONDS 5 // excluded from the statistics
+
+struct ImuSample {
+    float ax, ay, az;   // g
+    float gx, gy, gz;   // deg/s
+    float xTrue, yTrue; // deg
+    bool hasTruth;
+};
+
+// Tilts the way the sketch used to compute them, from a single accelerometer sample
+static float accelXAngle(const ImuSample& s) { return atan2(s.ax, sqrt(s.ay * s.ay + s.az * s.az)) * 180.0 / PI; }
+static float accelYAngle(const ImuSample& s) { return atan2(s.ay, sqrt(s.ax * s.ax + s.az * s.az)) * 180.0 / PI; }
+
+// True attitude as a quaternion, integrated from body rates with the filter's convention
+struct TruthModel {
+    double q0, q1, q2, q3;
+
+    void start(double xDeg, double yDeg) {
+        // Roll about X then pitch about Y, chosen so gravity makes the requested tilts
+        double gx = sin(xDeg * PI / 180.0);
+        double gy = sin(yDeg * PI / 180.0);
+        double gz = sqrt(std::max(0.0, 1.0 - gx * gx - gy * gy));
+        double roll = atan2(gy, gz);
+        double pitch = atan2(-gx, sqrt(gy * gy + gz * gz));
+        q0 = cos(roll / 2) * cos(pitch / 2);
+        q1 = sin(roll / 2) * cos(pitch / 2);
+        q2 = cos(roll / 2) * sin(pitch / 2);
+        q3 = -sin(roll / 2) * sin(pitch / 2);
+    }
+    void rotate(double wx, double wy, double wz, double dt) { // rad/s
+        double a = q0, b = q1, c = q2, d = q3;
+        q0 += 0.5 * dt * (-b * wx - c * wy - d * wz);
+        q1 += 0.5 * dt * (a * wx + c * wz - d * wy);
+        q2 += 0.5 * dt * (a * wy - b * wz + d * wx);
+        q3 += 0.5 * dt * (a * wz + b * wy - c * wx);
+        double n = sqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+        q0 /= n; q1 /= n; q2 /= n; q3 /= n;
+    }
+    void gravity(double& x, double& y, double& z) const {
+        x = 2.0 * (q1 * q3 - q0 * q2);
+        y = 2.0 * (q0 * q1 + q2 * q3);
+        z = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+    }
+};
+
+enum TraceKind { TRACE_VIBRATION, TRACE_SWAY, TRACE_BIAS };
+
+static std::vector<ImuSample> makeTrace(TraceKind kind) {
+    std::mt19937 rng(1234 + kind);
+    std::normal_distribution<double> accelNoise(0.0, 0.01); // g
+    std::normal_distribution<double> gyroNoise(0.0, 0.15);  // deg/s
+    const double dt = 1.0 / BENCH_RATE_HZ;
+    const int substeps = 10;
+    const double vibration = kind == TRACE_BIAS ? 0.0 : 0.5; // g at 47 Hz
+    const double bias[3] = {kind == TRACE_BIAS ? 2.0 : 0.4, kind == TRACE_BIAS ? -1.5 : -0.3, 0.2};
+
+    TruthModel truth;
+    truth.start(20.0, -10.0);
+    std::vector<ImuSample> trace;
+    for (int i = 0; i < BENCH_SECONDS * BENCH_RATE_HZ; i++) {
+        double t = i * dt;
+        double w[3] = {0.0, 0.0, 0.0}; // deg/s
+        if (kind == TRACE_SWAY) {
+            w[0] = 40.0 * sin(2.0 * PI * 0.5 * t);
+            w[1] = 30.0 * sin(2.0 * PI * 0.3 * t + 1.0);
+            w[2] = 10.0 * sin(2.0 * PI * 0.1 * t);
+        }
+        for (int k = 0; k < substeps; k++) truth.rotate(w[0] * PI / 180.0, w[1] * PI / 180.0, w[2] * PI / 180.0, dt / substeps);
+
+        double gx, gy, gz;
+        truth.gravity(gx, gy, gz);
+        double shake = vibration * sin(2.0 * PI * 47.0 * t);
+        ImuSample s;
+        s.ax = (float)(gx + shake * 0.6 + accelNoise(rng));
+        s.ay = (float)(gy - shake * 0.3 + accelNoise(rng));
+        s.az = (float)(gz + shake + accelNoise(rng));
+        s.gx = (float)(w[0] + bias[0] + gyroNoise(rng));
+        s.gy = (float)(w[1] + bias[1] + gyroNoise(rng));
+        s.gz = (float)(w[2] + bias[2] + gyroNoise(rng));
+        s.xTrue = (float)(atan2(gx, sqrt(gy * gy + gz * gz)) * 180.0 / PI);
+        s.yTrue = (float)(atan2(gy, sqrt(gx * gx + gz * gz)) * 180.0 / PI);
+        s.hasTruth = true;
+        trace.push_back(s);
+    }
+    return trace;
+}
+
+// Pass limits for a trace with known attitude
+struct TraceLimits {
+    double rmsDeg, maxDeg;     // fused tilt error after the settle time
+    double minGated, maxGated; // share of samples skipped by the accelerometer gate
+};
+
+static bool loadTrace(const char* path, std::vector<ImuSample>& trace, TraceLimits& limits, bool& hasLimits) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    char line[256];
+    hasLimits = false;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, " # limits %lf %lf %lf %lf", &limits.rmsDeg, &limits.maxDeg, &limits.minGated,
+                   &limits.maxGated) == 4) {
+            hasLimits = true;
+            continue;
+        }
+        double t;
+        ImuSample s;
+        int n = sscanf(line, "%lf,%f,%f,%f,%f,%f,%f,%f,%f", &t, &s.ax, &s.ay, &s.az, &s.gx, &s.gy, &s.gz, &s.xTrue, &s.yTrue);
+        if (n < 7) continue; // header or comment
+        s.hasTruth = n >= 9;
+        trace.push_back(s);
+    }
+    fclose(f);
+    return !trace.empty();
+}
+
+struct AngleStats {
+    double sumSqr, worst, jitterSqr;
+    unsigned long n;
+    float lastX, lastY;
+
+    void reset() { sumSqr = worst = jitterSqr = 0.0; n = 0; }
+    void add(float x, float y, const ImuSample& s) {
+        if (s.hasTruth) {
+            double ex = x - s.xTrue, ey = y - s.yTrue;
+            sumSqr += ex * ex + ey * ey;
+            worst = std::max(worst, std::max(fabs(ex), fabs(ey)));
+        }
+        if (n) jitterSqr += (x - lastX) * (x - lastX) + (y - lastY) * (y - lastY);
+        lastX = x;
+        lastY = y;
+        n++;
+    }
+    double rms() const { return n ? sqrt(sumSqr / (2.0 * n)) : 0.0; }
+    double jitter() const { return n > 1 ? sqrt(jitterSqr / (2.0 * (n - 1))) : 0.0; }
+};
+
+static bool check(const char* name, const char* what, double value, double low, double high) {
+    if (value >= low && value <= high) return true;
+    printf("%-10s FAIL: %s %.3g outside [%.3g, %.3g]\n", name, what, value, low, high);
+    return false;
+}
+
+// Run one trace and report it; returns false if it is over `limits`
+static bool runTrace(const char* name, const std::vector<ImuSample>& trace, const TraceLimits* limits = NULL) {
+    OrientationFilter filter(BENCH_RATE_HZ);
+    AngleStats fused, accel;
+    fused.reset();
+    accel.reset();
+    double totalNs = 0.0, diffSqr = 0.0;
+    unsigned long settle = BENCH_SETTLE_SECONDS * BENCH_RATE_HZ;
+
+    for (size_t i = 0; i < trace.size(); i++) {
+        const ImuSample& s = trace[i];
+        auto t0 = std::chrono::steady_clock::now();
+        filter.update(s.ax, s.ay, s.az, s.gx, s.gy, s.gz);
+        float x = filter.xAngle();
+        float y = filter.yAngle();
+        auto t1 = std::chrono::steady_clock::now();
+        totalNs += (double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+        if (i < settle) continue;
+        float xa = accelXAngle(s), ya = accelYAngle(s);
+        fused.add(x, y, s);
+        accel.add(xa, ya, s);
+        diffSqr += (x - xa) * (x - xa) + (y - ya) * (y - ya);
+    }
+
+    bool truth = !trace.empty() && trace[0].hasTruth;
+    if (truth) {
+        printf("%-10s %-6s rms %6.2f  max %6.2f  jitter %6.3f deg\n", name, "accel", accel.rms(), accel.worst, accel.jitter());
+        printf("%-10s %-6s rms %6.2f  max %6.2f  jitter %6.3f deg\n", "", "fused", fused.rms(), fused.worst, fused.jitter());
+    } else {
+        printf("%-10s %-6s jitter %6.3f deg\n", name, "accel", accel.jitter());
+        printf("%-10s %-6s jitter %6.3f deg, rms difference from accel %.2f deg\n", "", "fused", fused.jitter(),
+               fused.n ? sqrt(diffSqr / (2.0 * fused.n)) : 0.0);
+    }
+    double gated = (double)filter.rejected() / std::max<size_t>(1, trace.size());
+    printf("%-10s %lu samples, %.1f%% gated, update+angles %.0f ns\n", "", (unsigned long)trace.size(),
+           100.0 * gated, totalNs / std::max<size_t>(1, trace.size()));
+
+    if (!limits) return true;
+    bool pass = truth;
+    if (!truth) printf("%-10s FAIL: no true attitude to check against\n", name);
+    pass &= check(name, "fused rms error (deg)", fused.rms(), 0.0, limits->rmsDeg);
+    pass &= check(name, "fused max error (deg)", fused.worst, 0.0, limits->maxDeg);
+    pass &= check(name, "gated share", gated, limits->minGated, limits->maxGated);
+    return pass;
+}
+
+// The HAL's main() is disabled for this environment; these satisfy its declarations.
+void setup() {}
+void loop() {}
+
+int main(int argc, char** argv) {
+    double worstAtan = 0.0;
+    for (int i = 0; i < 3600; i++) {
+        double a = i * PI / 1800.0;
+        float y = (float)sin(a), x = (float)cos(a);
+        worstAtan = std::max(worstAtan, fabs(remainder((double)fastAtan2(y, x) - atan2(y, x), 2.0 * PI)));
+    }
+    printf("ORIENTATION_BENCH host: %d Hz, fastAtan2 max error %.2g rad\n", BENCH_RATE_HZ, worstAtan);
+
+    if (argc > 1) {
+        std::vector<ImuSample> trace;
+        TraceLimits limits;
+        bool hasLimits;
+        if (!loadTrace(argv[1], trace, limits, hasLimits)) {
+            printf("Could not read %s\n", argv[1]);
+            return 1;
+        }
+        if (!hasLimits) {
+            runTrace(argv[1], trace);
+            return 0;
+        }
+        bool pass = runTrace(argv[1], trace, &limits);
+        printf("%s\n", pass ? "PASS" : "FAIL");
+        return pass ? 0 : 1;
+    }
+    // Today: vibration 0.12 / 0.37 deg, sway 0.27 / 0.75 deg, gyro bias 0.04 / 0.14 deg
+    const TraceLimits vibration = {0.25, 0.75, 0.5, 1.0};
+    const TraceLimits sway = {0.5, 1.5, 0.5, 1.0};
+    const TraceLimits bias = {0.1, 0.3, 0.0, 0.01};
+    bool pass = true;
+    pass &= runTrace("vibration", makeTrace(TRACE_VIBRATION), &vibration);
+    pass &= runTrace("sway", makeTrace(TRACE_SWAY), &sway);
+    pass &= runTrace("gyro bias", makeTrace(TRACE_BIAS), &bias);
+    printf("%s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
+
+#endif // ORIENTATION_BENCH_HOST
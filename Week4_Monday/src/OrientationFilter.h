@@ -0,0 +1,174 @@
+#ifndef ORIENTATION_FILTER_H
+#define ORIENTATION_FILTER_H
+
+// OrientationFilter.h
+// Mahony orientation filter for the BMI270, in single precision.
+//
+// The gyro is integrated into a quaternion every sample. The accelerometer pulls the
+// estimate back towards gravity through a proportional term (kp) and an integral term
+// (ki) that learns the gyro bias. Samples whose magnitude is far from 1 g (shaking,
+// bumps) only feed the gyro, so vibration does not show up in the angles.
+//
+// xAngle()/yAngle() are the tilts of the board's X and Y axes from horizontal, in
+// degrees: the same quantities as atan2(ax, sqrt(ay^2 + az^2)) on a still board, but
+// from the fused gravity direction instead of one raw accelerometer sample.
+//
+// update() takes accel in g and gyro in deg/s (the units of BMI270::data) and a fixed
+// sample period, so call it at the sensor's output data rate.
+
+#include <Arduino.h>
+#include <math.h>
+
+// Polynomial atan2, max error about 2e-4 rad (0.01 deg); no libm call on the hot path
+inline float fastAtan2(float y, float x) {
+    float ax = fabsf(x);
+    float ay = fabsf(y);
+    float hi = ax > ay ? ax : ay;
+    if (hi == 0.0f) return 0.0f;
+    float a = (ax > ay ? ay : ax) / hi;
+    float s = a * a;
+    float r = ((-0.0464964749f * s + 0.15931422f) * s - 0.327622764f) * s * a + a;
+    if (ay > ax) r = 1.57079637f - r;
+    if (x < 0.0f) r = 3.14159274f - r;
+    return y < 0.0f ? -r : r;
+}
+
+class OrientationFilter {
+public:
+    explicit OrientationFilter(float sampleHz = 200.0f)
+        : _kp(2.0f), _ki(1.0f), _gateLow(0.85f), _gateHigh(1.15f)
+    {
+        setSampleRate(sampleHz);
+        reset();
+    }
+
+    void setSampleRate(float hz) { _dt = hz > 0.0f ? 1.0f / hz : 0.005f; }
+
+    // Accelerometer correction gains (1/s)
+    void setGains(float kp, float ki) {
+        _kp = kp;
+        _ki = ki;
+    }
+
+    // Accelerometer samples outside [low, high] g are not used for correction
+    void setAccelGate(float low, float high) {
+        _gateLow = low;
+        _gateHigh = high;
+    }
+
+    // Start over; the next sample sets the attitude from the accelerometer alone
+    void reset() {
+        _q0 = 1.0f;
+        _q1 = _q2 = _q3 = 0.0f;
+        _ix = _iy = _iz = 0.0f;
+        _started = false;
+        _rejected = 0;
+    }
+
+    void update(float ax, float ay, float az, float gx, float gy, float gz) {
+        float n2 = ax * ax + ay * ay + az * az;
+        if (!_started) {
+            if (n2 <= 0.0f) return;
+            _initFromAccel(ax, ay, az);
+            _started = true;
+            return;
+        }
+
+        const float degToRad = 0.0174532925f;
+        gx *= degToRad;
+        gy *= degToRad;
+        gz *= degToRad;
+
+        if (n2 >= _gateLow * _gateLow && n2 <= _gateHigh * _gateHigh) {
+            float inv = 1.0f / sqrtf(n2);
+            ax *= inv;
+            ay *= inv;
+            az *= inv;
+            // Gravity direction predicted by the current attitude
+            float vx = 2.0f * (_q1 * _q3 - _q0 * _q2);
+            float vy = 2.0f * (_q0 * _q1 + _q2 * _q3);
+            float vz = _q0 * _q0 - _q1 * _q1 - _q2 * _q2 + _q3 * _q3;
+            // Error is the rotation from predicted to measured gravity
+            float ex = ay * vz - az * vy;
+            float ey = az * vx - ax * vz;
+            float ez = ax * vy - ay * vx;
+            if (_ki > 0.0f) {
+                _ix += _ki * ex * _dt;
+                _iy += _ki * ey * _dt;
+                _iz += _ki * ez * _dt;
+            }
+            gx += _kp * ex;
+            gy += _kp * ey;
+            gz += _kp * ez;
+        } else {
+            _rejected++;
+        }
+        gx += _ix;
+        gy += _iy;
+        gz += _iz;
+
+        // q += q * (0, g) * dt / 2
+        gx *= 0.5f * _dt;
+        gy *= 0.5f * _dt;
+        gz *= 0.5f * _dt;
+        float q0 = _q0, q1 = _q1, q2 = _q2;
+        _q0 += -q1 * gx - q2 * gy - _q3 * gz;
+        _q1 += q0 * gx + q2 * gz - _q3 * gy;
+        _q2 += q0 * gy - q1 * gz + _q3 * gx;
+        _q3 += q0 * gz + q1 * gy - q2 * gx;
+        _normalise();
+    }
+
+    // Tilt of the X and Y axes from horizontal, degrees
+    float xAngle() const {
+        float vx, vy, vz;
+        _gravity(vx, vy, vz);
+        return fastAtan2(vx, sqrtf(vy * vy + vz * vz)) * 57.2957795f;
+    }
+    float yAngle() const {
+        float vx, vy, vz;
+        _gravity(vx, vy, vz);
+        return fastAtan2(vy, sqrtf(vx * vx + vz * vz)) * 57.2957795f;
+    }
+
+    // Accelerometer samples skipped by the gate since reset()
+    unsigned long rejected() const { return _rejected; }
+
+private:
+    float _kp, _ki;
+    float _gateLow, _gateHigh;
+    float _dt;
+    float _q0, _q1, _q2, _q3;
+    float _ix, _iy, _iz;   // integral feedback, rad/s (gyro bias estimate)
+    bool _started;
+    unsigned long _rejected;
+
+    void _gravity(float& vx, float& vy, float& vz) const {
+        vx = 2.0f * (_q1 * _q3 - _q0 * _q2);
+        vy = 2.0f * (_q0 * _q1 + _q2 * _q3);
+        vz = _q0 * _q0 - _q1 * _q1 - _q2 * _q2 + _q3 * _q3;
+    }
+
+    // Roll/pitch from gravity, yaw zero
+    void _initFromAccel(float ax, float ay, float az) {
+        float roll = atan2f(ay, az);
+        float pitch = atan2f(-ax, sqrtf(ay * ay + az * az));
+        float cr = cosf(roll * 0.5f), sr = sinf(roll * 0.5f);
+        float cp = cosf(pitch * 0.5f), sp = sinf(pitch * 0.5f);
+        _q0 = cr * cp;
+        _q1 = sr * cp;
+        _q2 = cr * sp;
+        _q3 = -sr * sp;
+    }
+
+    void _normalise() {
+        float n = _q0 * _q0 + _q1 * _q1 + _q2 * _q2 + _q3 * _q3;
+        float inv = 1.0f / sqrtf(n);
+        _q0 *= inv;
+        _q1 *= inv;
+        _q2 *= inv;
+        _q3 *= inv;
+    }
+};
+
+#endif // ORIENTATION_FILTER_H
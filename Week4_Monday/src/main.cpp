@@ -5,6 +5,9 @@
 // libraries for led screen and accel
 #include "SparkFun_BMI270_Arduino_Library.h"
 #include <SparkFun_Qwiic_OLED.h>
+#include "OrientationFilter.h"
+#include "ImuFifo.h"
+#include "ButtonInput.h"
 
 // Create appropriate obj for led and accel
 
@@ -14,9 +17,26 @@ BMI270 imu;
 volatile int buttonCounter = 0;
 bool prevPressed = false;
 int switchPin = 10;
-unsigned long debounceDelay = 50;
 unsigned long doublePressTime = 500;
-unsigned long prevTime = 0; 
+unsigned long longPressTime = 800;
+
+// The switch is sampled every buttonSampleMs from a timer and debounced there; loop()
+// reads the resulting single/double/long press events.
+unsigned long buttonSampleMs = 5;
+ButtonInput buttons;
+int8_t switchButton = -1;
+
+// The BMI270 queues samples in its FIFO at the ODR. imuDrain() empties it in bursts
+// into a ring, from a timer (a FreeRTOS task on the ESP32); loop() feeds every queued
+// sample to the orientation filter before drawing, so no sample is lost to a slow frame.
+uint8_t imuOdr = BMI2_ACC_ODR_400HZ;
+uint16_t imuWatermark = 16;      // frames per burst, 40 ms at 400 Hz
+unsigned long imuDrainMs = 10;
+int imuIntPin = -1;              // GPIO wired to BMI270 INT1; -1 polls the FIFO length
+unsigned long imuReportMs = 5000;
+ImuFifo imuFifo(imu);
+OrientationFilter orientation;
+ImuSample lastSample = {0, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f};
 
 float theta = 0.0;
 float psi = 0.0;
@@ -42,8 +62,8 @@ enum MachineState {
   StateLength
 };
 
-volatile PressType currentPress = NoPress;
-volatile MachineState currentState = OffState;
+PressType currentPress = NoPress;
+MachineState currentState = OffState;
 
 // Triangle draw function
 void drawTriangle(int xOff, int yOff, int xDir, int yDir, bool swap) {
@@ -59,27 +79,70 @@ void drawTriangle(int xOff, int yOff, int xDir, int yDir, bool swap) {
   
 }
 
-float getXangle() {
-    return atan2(imu.data.accelX, sqrt(imu.data.accelY * imu.data.accelY + imu.data.accelZ * imu.data.accelZ)) * 180.0 / PI;
+void imuDrain() {
+  imuFifo.drain();
 }
 
-float getYangle() {
-    return atan2(imu.data.accelY, sqrt(imu.data.accelX * imu.data.accelX + imu.data.accelZ * imu.data.accelZ)) * 180.0 / PI;
-    //phi = atan2(sqrt(imu.data.accelY * imu.data.accelY + imu.data.accelX * imu.data.accelX), imu.data.accelZ);
+#if defined(ESP32) && !defined(NATIVE_HAL)
+// IMU drain task; Wire serialises the BMI270 and OLED transactions
+void imuTask(void*) {
+  TickType_t wake = xTaskGetTickCount();
+  for (;;) {
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(imuDrainMs));
+    imuDrain();
+  }
+}
+#endif
+
+// Every queued sample into the filter, in order
+void imuConsume() {
+  ImuSample s;
+  while (imuFifo.read(s)) {
+    orientation.update(s.ax, s.ay, s.az, s.gx, s.gy, s.gz);
+    lastSample = s;
+  }
 }
 
-void buttonPress() {
-  unsigned long currentTime = millis();
-  if (currentTime - prevTime > debounceDelay) {
-    if (currentTime - prevTime < doublePressTime) {
-      currentPress = DoublePress;
-    } else {
-      currentPress = SinglePress;
-    }
-    prevTime = currentTime;
+void imuReport() {
+  static unsigned long lastReport = 0;
+  if (millis() - lastReport < imuReportMs) return;
+  lastReport = millis();
+  Serial.print("IMU samples=");
+  Serial.print(imuFifo.samples());
+  Serial.print(" bursts=");
+  Serial.print(imuFifo.bursts());
+  Serial.print(" dropped=");
+  Serial.print(imuFifo.dropped());
+  Serial.print(" fifoOverflows=");
+  Serial.println(imuFifo.overflows());
+}
 
+void buttonSample() {
+  buttons.sample();
+}
+
+#if defined(ESP32) && !defined(NATIVE_HAL)
+void buttonTask(void*) {
+  TickType_t wake = xTaskGetTickCount();
+  for (;;) {
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(buttonSampleMs));
+    buttonSample();
   }
 }
+#endif
+
+// Latest press event from the switch, if any
+PressType readPress() {
+  ButtonEvent e;
+  PressType press = NoPress;
+  while (buttons.read(e)) {
+    if (e.button != switchButton) continue;
+    if (e.type == BUTTON_SINGLE) press = SinglePress;
+    else if (e.type == BUTTON_DOUBLE) press = DoublePress;
+    else if (e.type == BUTTON_LONG) press = LongPress;
+  }
+  return press;
+}
 
 void setup() {
   delay(1000);
@@ -88,24 +151,45 @@ void setup() {
     yield();
   } 
   pinMode(switchPin, INPUT_PULLDOWN);
-  attachInterrupt(switchPin, buttonPress, RISING); 
+  switchButton = buttons.add(switchPin, true, doublePressTime, longPressTime);
 
   // Start accel
   Wire.begin();
   while (imu.beginI2C(0x68) != BMI2_OK) {
     delay(1000);
   }
+  imuFifo.begin(imuOdr, imuWatermark);
+  if (imuIntPin >= 0) imuFifo.useInterruptPin(imuIntPin);
+  orientation.setSampleRate(1000000.0f / imuFifo.periodMicros());
   // Start LED screen
   while (!myOLED.begin()) {
     delay(1000);
   }
   Serial.println("Everything started!!!!!");
+#if defined(NATIVE_HAL)
+  hal::every(imuDrainMs * 1000UL, imuDrain);
+  hal::every(buttonSampleMs * 1000UL, buttonSample);
+#elif defined(ESP32)
+  xTaskCreate(imuTask, "imu", 4096, NULL, 2, NULL);
+  xTaskCreate(buttonTask, "buttons", 2048, NULL, 3, NULL);
+#endif
 }
 
 void loop() {
+#if !defined(ESP32) && !defined(NATIVE_HAL)
+  // No timer task on this board: sample from loop() when due
+  static unsigned long nextButtonSample = 0;
+  if ((long)(millis() - nextButtonSample) >= 0) {
+    nextButtonSample += buttonSampleMs;
+    buttonSample();
+  }
+#endif
+  currentPress = readPress();
   if (currentPress == DoublePress ) { //&& currentState != OffState
     currentState = (MachineState)(((int)currentState + 1) % (int)StateLength);
     currentState = (MachineState)max((int)currentState, 1);
+  } else if (currentPress == LongPress) {
+    currentState = OffState;
   }
   if (currentPress != NoPress) {
     Serial.print("Current State type: ");
@@ -115,10 +199,14 @@ void loop() {
 
   // erase screen
   myOLED.erase(); 
-  // get imu data
-  imu.getSensorData();
-  theta = getXangle();
-  psi = getYangle();
+#if !defined(ESP32) && !defined(NATIVE_HAL)
+  // No timer task on this board: drain from loop()
+  imuDrain();
+#endif
+  imuConsume();
+  imuReport();
+  theta = orientation.xAngle();
+  psi = orientation.yAngle();
   switch (currentState)
   {
   case OffState:
@@ -146,11 +234,11 @@ void loop() {
 
     break;
   case RawData: 
-    sprintf(pout, "ax: %.2f", imu.data.accelX);
+    sprintf(pout, "ax: %.2f", lastSample.ax);
     myOLED.text(0,0, pout);
-    sprintf(pout, "ay: %.2f", imu.data.accelY);
+    sprintf(pout, "ay: %.2f", lastSample.ay);
     myOLED.text(0,10, pout);
-    sprintf(pout, "az: %.2f", imu.data.accelZ);
+    sprintf(pout, "az: %.2f", lastSample.az);
     myOLED.text(0,20, pout);
 
     break;
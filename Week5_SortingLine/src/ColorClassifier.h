@@ -0,0 +1,223 @@
+#ifndef COLOR_CLASSIFIER_H
+#define COLOR_CLASSIFIER_H
+
+// ColorClassifier.h
+// Colour classification for the sorting line.
+//
+// Sampling: the colour input is read at a fixed period instead of on every scan, so
+// the analog transaction no longer sets the scan time. Raw readings are averaged in
+// blocks of `decimation` samples, and a part's feature is the minimum block average
+// seen while it is in front of the sensor (the sensor reads lowest when the part is
+// centred). Each part carries its own Window.
+//
+// Statistics: every confirmed sort adds the part's feature to a fixed-size history of
+// its class. Running sums give the class mean and variance without rescanning.
+//
+// Thresholds: once two neighbouring classes both have CLASSIFIER_MIN_SAMPLES, the
+// boundary between them moves to the point that is the same number of standard
+// deviations from both means. Until then the configured defaults are used. Only parts
+// the line confirms feed the statistics, so they follow a slow drift of the sensor but
+// cannot recover a class that has already drifted across a boundary.
+//
+// Classes are ordered by feature value: 0 = white, 1 = red, 2 = blue.
+
+#include <Arduino.h>
+#include <math.h>
+
+#define CLASSIFIER_CLASSES 3
+
+#ifndef CLASSIFIER_HISTORY
+#define CLASSIFIER_HISTORY 16 // confirmed features kept per class
+#endif
+
+#ifndef CLASSIFIER_MIN_SAMPLES
+#define CLASSIFIER_MIN_SAMPLES 4 // per class before its boundaries adapt
+#endif
+
+class ColorClassifier {
+public:
+    // Per-part sampling window
+    struct Window {
+        int feature;      // minimum block average so far, NO_FEATURE if none
+        long blockSum;
+        uint8_t blockCount;
+        uint16_t samples; // raw samples taken
+
+        void reset() {
+            feature = NO_FEATURE;
+            blockSum = 0;
+            blockCount = 0;
+            samples = 0;
+        }
+        bool valid() const { return feature != NO_FEATURE; }
+    };
+
+    enum { NO_FEATURE = 0x7FFF };
+
+    ColorClassifier(unsigned long samplePeriodUs = 2000, uint8_t decimation = 4)
+        : _samplePeriodUs(samplePeriodUs), _decimation(decimation ? decimation : 1),
+          _nextSample(0)
+    {
+        _defaults[0] = 2500;
+        _defaults[1] = 4600;
+        _threshold[0] = _defaults[0];
+        _threshold[1] = _defaults[1];
+        for (uint8_t c = 0; c < CLASSIFIER_CLASSES; c++) _clearClass(c);
+    }
+
+    void setSamplePeriod(unsigned long us) { _samplePeriodUs = us; }
+    unsigned long getSamplePeriod() const { return _samplePeriodUs; }
+    void setDecimation(uint8_t n) { _decimation = n ? n : 1; }
+    uint8_t getDecimation() const { return _decimation; }
+
+    // Thresholds used until the statistics take over: below t0 is white, below t1 red
+    void setDefaultThresholds(int t0, int t1) {
+        _defaults[0] = t0;
+        _defaults[1] = t1;
+        _updateThresholds();
+    }
+    int getThreshold(uint8_t boundary) const { return _threshold[boundary]; }
+
+    // True once per sample period; the caller then reads the input and calls addSample()
+    bool sampleDue(unsigned long nowUs) {
+        if ((long)(nowUs - _nextSample) < 0) return false;
+        _nextSample += _samplePeriodUs;
+        // Fell more than a period behind (e.g. sampling was idle): restart from now
+        if ((long)(nowUs - _nextSample) >= 0) _nextSample = nowUs + _samplePeriodUs;
+        return true;
+    }
+
+    void addSample(Window& w, int raw) const {
+        w.samples++;
+        w.blockSum += raw;
+        if (++w.blockCount < _decimation) return;
+        int avg = (int)(w.blockSum / w.blockCount);
+        if (avg < w.feature) w.feature = avg;
+        w.blockSum = 0;
+        w.blockCount = 0;
+    }
+
+    // Feature of a finished window. A partial last block still counts, so a part that
+    // only got a few samples is not lost.
+    int feature(const Window& w) const {
+        int f = w.feature;
+        if (w.blockCount) {
+            int avg = (int)(w.blockSum / w.blockCount);
+            if (avg < f) f = avg;
+        }
+        return f;
+    }
+
+    uint8_t classify(int feature) const {
+        uint8_t c = 0;
+        while (c < CLASSIFIER_CLASSES - 1 && feature >= _threshold[c]) c++;
+        return c;
+    }
+
+    // Record a part of class c as correctly sorted and adapt the thresholds
+    void confirm(uint8_t c, int feature) {
+        if (c >= CLASSIFIER_CLASSES || feature == NO_FEATURE) return;
+        ClassStats& s = _stats[c];
+        if (s.count == CLASSIFIER_HISTORY) {
+            int old = s.history[s.head];
+            s.sum -= old;
+            s.sumSq -= (uint64_t)((long)old * old);
+        } else {
+            s.count++;
+        }
+        s.history[s.head] = feature;
+        s.head = (s.head + 1) % CLASSIFIER_HISTORY;
+        s.sum += feature;
+        s.sumSq += (uint64_t)((long)feature * feature);
+        _updateThresholds();
+    }
+
+    uint8_t count(uint8_t c) const { return _stats[c].count; }
+    float mean(uint8_t c) const {
+        const ClassStats& s = _stats[c];
+        return s.count ? (float)s.sum / s.count : 0.0f;
+    }
+    float variance(uint8_t c) const {
+        const ClassStats& s = _stats[c];
+        if (!s.count) return 0.0f;
+        float m = (float)s.sum / s.count;
+        float v = (float)s.sumSq / s.count - m * m;
+        return v > 0.0f ? v : 0.0f;
+    }
+
+    // Forget the statistics of every class and go back to the default thresholds
+    void resetStats() {
+        for (uint8_t c = 0; c < CLASSIFIER_CLASSES; c++) _clearClass(c);
+        _updateThresholds();
+    }
+
+    // Per-class count/mean/sd, then each boundary with its separation d' (distance
+    // between the means in pooled standard deviations; above ~3 the classes are clean)
+    void printStats(Print& out) const {
+        static const char names[CLASSIFIER_CLASSES] = {'w', 'r', 'b'};
+        for (uint8_t c = 0; c < CLASSIFIER_CLASSES; c++) {
+            out.print(names[c]);
+            out.print(" n=");
+            out.print(count(c));
+            out.print(" mean=");
+            out.print(mean(c), 0);
+            out.print(" sd=");
+            out.println(sqrtf(variance(c)), 0);
+        }
+        for (uint8_t b = 0; b < CLASSIFIER_CLASSES - 1; b++) {
+            out.print(names[b]);
+            out.print('/');
+            out.print(names[b + 1]);
+            out.print(" threshold=");
+            out.print(_threshold[b]);
+            out.print(" d'=");
+            float pooled = sqrtf((variance(b) + variance(b + 1)) * 0.5f);
+            if (count(b) && count(b + 1) && pooled > 0.0f) out.println(fabsf(mean(b + 1) - mean(b)) / pooled, 1);
+            else out.println('-');
+        }
+    }
+
+private:
+    struct ClassStats {
+        int history[CLASSIFIER_HISTORY];
+        uint8_t head;
+        uint8_t count;
+        long sum;
+        uint64_t sumSq;
+    };
+
+    unsigned long _samplePeriodUs;
+    uint8_t _decimation;
+    unsigned long _nextSample;
+    int _defaults[CLASSIFIER_CLASSES - 1];
+    int _threshold[CLASSIFIER_CLASSES - 1];
+    ClassStats _stats[CLASSIFIER_CLASSES];
+
+    void _clearClass(uint8_t c) {
+        ClassStats& s = _stats[c];
+        s.head = 0;
+        s.count = 0;
+        s.sum = 0;
+        s.sumSq = 0;
+    }
+
+    void _updateThresholds() {
+        for (uint8_t b = 0; b < CLASSIFIER_CLASSES - 1; b++) {
+            _threshold[b] = _defaults[b];
+            if (count(b) < CLASSIFIER_MIN_SAMPLES || count(b + 1) < CLASSIFIER_MIN_SAMPLES) continue;
+            float m0 = mean(b);
+            float m1 = mean(b + 1);
+            if (m1 <= m0) continue; // classes overlap completely, keep the default
+            // A few tightly grouped parts underestimate a class's spread and would pull
+            // the boundary right up to it, so each sd is floored at a quarter of the gap
+            float floorSd = (m1 - m0) * 0.25f;
+            float s0 = max(sqrtf(variance(b)), floorSd);
+            float s1 = max(sqrtf(variance(b + 1)), floorSd);
+            // Equal z-score point
+            float t = (m0 * s1 + m1 * s0) / (s0 + s1);
+            _threshold[b] = (int)(t + 0.5f);
+        }
+    }
+};
+
+#endif // COLOR_CLASSIFIER_H
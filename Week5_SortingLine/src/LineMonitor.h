@@ -0,0 +1,220 @@
+#ifndef LINE_MONITOR_H
+#define LINE_MONITOR_H
+
+// LineMonitor.h
+// Cycle-time and throughput instrumentation for the sorting line.
+//
+// The sketch marks each part's transitions (lbIn, lbOut, ejector open/close). Every
+// mark costs one micros() read and a ring buffer store, and the time since the part's
+// previous mark is folded into the min/max/mean of the phase that just ended. Ejected
+// parts are counted by colour for parts-per-minute. The scan time is tracked as its own
+// phase, so a slow stage shows up next to the loop it is slowing down.
+//
+// Reports are written one line per scan and only when the serial port has room for
+// the whole line, so asking for a report never blocks the scan on a slow port.
+
+#include <Arduino.h>
+#include <stdio.h>
+
+#ifndef LINE_MONITOR_EVENTS
+#define LINE_MONITOR_EVENTS 32 // transitions kept in the ring buffer
+#endif
+
+#define LINE_MONITOR_COLORS 3
+#ifndef LINE_MONITOR_LINE
+#define LINE_MONITOR_LINE 64   // longest report line, including the newline
+#endif
+
+class LineMonitor {
+public:
+    // Phases of a part on the line, plus the belt and the scan itself
+    enum Phase {
+        PHASE_IDLE = 0, // belt empty, waiting for a part at lbIn
+        PHASE_SENSING,  // lbIn to lbOut
+        PHASE_TRAVEL,   // lbOut to its ejector opening
+        PHASE_EJECT,    // ejector valve open
+        PHASE_PART,     // lbIn to ejector opening: the part's cycle time
+        PHASE_SCAN,     // one pass of loop()
+        PHASE_COUNT
+    };
+
+    // Transitions stored in the ring buffer
+    enum Event {
+        EVENT_ENTER = 0, // part tripped lbIn
+        EVENT_CLASSIFY,  // part passed lbOut
+        EVENT_EJECT,     // ejector opened for the part
+        EVENT_RELEASE,   // ejector closed
+        EVENT_LOST       // part could not be tracked
+    };
+
+    struct Entry {
+        uint32_t time;  // micros()
+        uint16_t part;  // part number, counted from 1 at power up
+        uint8_t event;
+        uint8_t color;  // class for EVENT_CLASSIFY / EVENT_EJECT
+    };
+
+    LineMonitor() : _scanStart(0), _scanValid(false) { reset(); }
+
+    // Clear all statistics and start a new throughput window
+    void reset() {
+        for (uint8_t i = 0; i < PHASE_COUNT; i++) {
+            _phase[i].count = 0;
+            _phase[i].min = 0xFFFFFFFFUL;
+            _phase[i].max = 0;
+            _phase[i].sum = 0;
+        }
+        for (uint8_t c = 0; c < LINE_MONITOR_COLORS; c++) _sorted[c] = 0;
+        _elapsed = 0;
+        _tick = micros();
+        _head = 0;
+        _events = 0;
+        _report = REPORT_NONE;
+    }
+
+    // Record a transition and return its timestamp
+    uint32_t mark(uint8_t event, uint16_t part, uint8_t color = 0) {
+        uint32_t now = micros();
+        Entry& e = _ring[_head];
+        e.time = now;
+        e.part = part;
+        e.event = event;
+        e.color = color;
+        _head = (_head + 1) % LINE_MONITOR_EVENTS;
+        _events++;
+        return now;
+    }
+
+    // Fold one duration into the statistics of phase p
+    void phaseDone(uint8_t p, uint32_t us) {
+        PhaseStats& s = _phase[p];
+        s.count++;
+        s.sum += us;
+        if (us < s.min) s.min = us;
+        if (us > s.max) s.max = us;
+    }
+
+    void sorted(uint8_t color) {
+        if (color < LINE_MONITOR_COLORS) _sorted[color]++;
+    }
+
+    // Scan timing: call at the top of loop(), the previous scan ends there
+    void scan() {
+        uint32_t now = micros();
+        _advance(now);
+        if (_scanValid) phaseDone(PHASE_SCAN, now - _scanStart);
+        _scanStart = now;
+        _scanValid = true;
+    }
+
+    unsigned long count(uint8_t p) const { return _phase[p].count; }
+    uint32_t minimum(uint8_t p) const { return _phase[p].count ? _phase[p].min : 0; }
+    uint32_t maximum(uint8_t p) const { return _phase[p].max; }
+    uint32_t mean(uint8_t p) const { return _phase[p].count ? (uint32_t)(_phase[p].sum / _phase[p].count) : 0; }
+
+    // Parts of a colour per minute, in hundredths, since the last reset()
+    uint32_t partsPerMinute100(uint8_t color) const {
+        uint64_t elapsed = _elapsed + (uint32_t)(micros() - _tick);
+        if (!elapsed || color >= LINE_MONITOR_COLORS) return 0;
+        return (uint32_t)((uint64_t)_sorted[color] * 6000000000ULL / elapsed);
+    }
+
+    // Start a report; it is written by update() a line at a time
+    void requestSummary() { _report = REPORT_SUMMARY; _line = 0; }
+    void requestEvents() {
+        _report = REPORT_EVENTS;
+        _line = 0;
+        // Snapshot the range now so new transitions do not stretch the dump (entries
+        // overwritten while it is being written show up with their newer contents)
+        _dumpCount = _events < LINE_MONITOR_EVENTS ? (uint8_t)_events : LINE_MONITOR_EVENTS;
+        _dumpFirst = (_head + LINE_MONITOR_EVENTS - _dumpCount) % LINE_MONITOR_EVENTS;
+    }
+    bool reporting() const { return _report != REPORT_NONE; }
+
+    // Write at most one report line, if the port has room for it
+    template <class Port>
+    void update(Port& out) {
+        _advance(micros());
+        if (_report == REPORT_NONE) return;
+        char buf[LINE_MONITOR_LINE];
+        int len = (_report == REPORT_SUMMARY) ? _summaryLine(buf, sizeof(buf)) : _eventLine(buf, sizeof(buf));
+        if (len < 0) {
+            _report = REPORT_NONE;
+            return;
+        }
+        if (len >= (int)sizeof(buf)) {
+            // Cut the text, not the line end: the last two characters that fit become CRLF
+            len = sizeof(buf) - 1;
+            buf[len - 2] = '\r';
+            buf[len - 1] = '\n';
+        }
+        if (out.availableForWrite() < len) return; // try again next scan
+        out.write((const uint8_t*)buf, len);
+        _line++;
+    }
+
+private:
+    struct PhaseStats {
+        unsigned long count;
+        uint32_t min;
+        uint32_t max;
+        uint64_t sum;
+    };
+
+    enum { REPORT_NONE, REPORT_SUMMARY, REPORT_EVENTS };
+
+    // Fold the time since the last call into _elapsed; scan() and update() call this
+    // every loop(), far more often than micros() wraps (about 71.6 minutes)
+    void _advance(uint32_t now) {
+        _elapsed += (uint32_t)(now - _tick);
+        _tick = now;
+    }
+
+    PhaseStats _phase[PHASE_COUNT];
+    unsigned long _sorted[LINE_MONITOR_COLORS];
+    uint64_t _elapsed; // micros since reset(), accumulated so it outlives the micros() wrap
+    uint32_t _tick;    // micros() when _elapsed was last brought up to date
+    uint32_t _scanStart;
+    bool _scanValid;
+
+    Entry _ring[LINE_MONITOR_EVENTS];
+    uint8_t _head;
+    unsigned long _events;
+
+    uint8_t _report;
+    uint8_t _line;
+    uint8_t _dumpFirst;
+    uint8_t _dumpCount;
+
+    static const char* _phaseName(uint8_t p) {
+        static const char* const names[PHASE_COUNT] = {"idle", "sensing", "travel", "eject", "part", "scan"};
+        return names[p];
+    }
+    static char _colorName(uint8_t c) { return c < LINE_MONITOR_COLORS ? "wrb"[c] : '?'; }
+
+    // Line n of the summary into buf; returns its length or -1 past the end
+    int _summaryLine(char* buf, size_t size) {
+        if (_line < PHASE_COUNT) {
+            uint8_t p = _line;
+            return snprintf(buf, size, "%-7s n=%lu min=%lu mean=%lu max=%lu us\r\n", _phaseName(p),
+                            count(p), (unsigned long)minimum(p), (unsigned long)mean(p), (unsigned long)maximum(p));
+        }
+        uint8_t c = _line - PHASE_COUNT;
+        if (c < LINE_MONITOR_COLORS) {
+            uint32_t ppm = partsPerMinute100(c);
+            return snprintf(buf, size, "%c sorted=%lu ppm=%lu.%02lu\r\n", _colorName(c),
+                            _sorted[c], (unsigned long)(ppm / 100), (unsigned long)(ppm % 100));
+        }
+        return -1;
+    }
+
+    int _eventLine(char* buf, size_t size) {
+        if (_line >= _dumpCount) return -1;
+        static const char* const names[] = {"enter", "classify", "eject", "release", "lost"};
+        const Entry& e = _ring[(_dumpFirst + _line) % LINE_MONITOR_EVENTS];
+        return snprintf(buf, size, "%lu #%u %s %c\r\n", (unsigned long)e.time, (unsigned)e.part, names[e.event],
+                        (e.event == EVENT_CLASSIFY || e.event == EVENT_EJECT) ? _colorName(e.color) : '-');
+    }
+};
+
+#endif // LINE_MONITOR_H
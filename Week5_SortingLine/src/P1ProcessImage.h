@@ -0,0 +1,137 @@
+#ifndef P1_PROCESS_IMAGE_H
+#define P1_PROCESS_IMAGE_H
+
+// P1ProcessImage.h
+// PLC-style process image for P1AM discrete modules.
+// At the start of a scan readInputs() fetches every channel of each registered input
+// module in one backplane transaction (channel 0 = whole module). The scan logic then
+// reads inputs and sets outputs in RAM only, and writeOutputs() at the end of the scan
+// sends each output module in one transaction, and only if its image changed.
+// A scan therefore costs one transaction per input module plus at most one per output
+// module, no matter how many channels the logic touches.
+
+#include <Arduino.h>
+#include <P1AM.h>
+
+#ifndef P1_IMAGE_MAX_MODULES
+#define P1_IMAGE_MAX_MODULES 4
+#endif
+
+class P1ProcessImage {
+public:
+    P1ProcessImage() : _inputCount(0), _outputCount(0), _transactions(0) {}
+
+    bool addInputModule(uint8_t slot) {
+        if (_inputCount >= P1_IMAGE_MAX_MODULES) return false;
+        InputModule& m = _inputs[_inputCount++];
+        m.slot = slot;
+        m.bits = 0;
+        m.previous = 0;
+        return true;
+    }
+
+    bool addOutputModule(uint8_t slot) {
+        if (_outputCount >= P1_IMAGE_MAX_MODULES) return false;
+        OutputModule& m = _outputs[_outputCount++];
+        m.slot = slot;
+        m.bits = 0;
+        m.written = 0;
+        m.valid = false; // first writeOutputs() always sends the module
+        return true;
+    }
+
+    // Start of scan: one bulk read per input module.
+    void readInputs() {
+        for (uint8_t i = 0; i < _inputCount; i++) {
+            InputModule& m = _inputs[i];
+            m.previous = m.bits;
+            m.bits = P1.readDiscrete(m.slot);
+            _transactions++;
+        }
+    }
+
+    // End of scan: one bulk write per output module that changed.
+    void writeOutputs() {
+        for (uint8_t i = 0; i < _outputCount; i++) {
+            OutputModule& m = _outputs[i];
+            if (m.valid && m.bits == m.written) continue;
+            P1.writeDiscrete(m.bits, m.slot);
+            _transactions++;
+            m.written = m.bits;
+            m.valid = true;
+        }
+    }
+
+    // Input channel state from the last readInputs() (channels start at 1)
+    bool input(uint8_t slot, uint8_t channel) const {
+        const InputModule* m = _findInput(slot);
+        return m && channel >= 1 && ((m->bits >> (channel - 1)) & 1UL);
+    }
+    // Input went high / low between the last two scans
+    bool rose(uint8_t slot, uint8_t channel) const {
+        const InputModule* m = _findInput(slot);
+        if (!m || channel < 1) return false;
+        uint32_t mask = 1UL << (channel - 1);
+        return (m->bits & mask) && !(m->previous & mask);
+    }
+    bool fell(uint8_t slot, uint8_t channel) const {
+        const InputModule* m = _findInput(slot);
+        if (!m || channel < 1) return false;
+        uint32_t mask = 1UL << (channel - 1);
+        return !(m->bits & mask) && (m->previous & mask);
+    }
+
+    // Output channel state, sent on the next writeOutputs()
+    void setOutput(uint8_t slot, uint8_t channel, bool on) {
+        OutputModule* m = _findOutput(slot);
+        if (!m || channel < 1) return;
+        uint32_t mask = 1UL << (channel - 1);
+        if (on) m->bits |= mask;
+        else m->bits &= ~mask;
+    }
+    bool output(uint8_t slot, uint8_t channel) const {
+        const OutputModule* m = _findOutput(slot);
+        if (!m || channel < 1) return false;
+        return (m->bits >> (channel - 1)) & 1UL;
+    }
+
+    // Backplane transactions issued by the image (for comparing against per-channel access)
+    unsigned long transactions() const { return _transactions; }
+
+private:
+    struct InputModule {
+        uint8_t slot;
+        uint32_t bits;
+        uint32_t previous;
+    };
+    struct OutputModule {
+        uint8_t slot;
+        uint32_t bits;    // image the scan logic writes
+        uint32_t written; // last image sent to the module
+        bool valid;
+    };
+
+    InputModule _inputs[P1_IMAGE_MAX_MODULES];
+    OutputModule _outputs[P1_IMAGE_MAX_MODULES];
+    uint8_t _inputCount;
+    uint8_t _outputCount;
+    unsigned long _transactions;
+
+    const InputModule* _findInput(uint8_t slot) const {
+        for (uint8_t i = 0; i < _inputCount; i++) {
+            if (_inputs[i].slot == slot) return &_inputs[i];
+        }
+        return NULL;
+    }
+    const OutputModule* _findOutput(uint8_t slot) const {
+        for (uint8_t i = 0; i < _outputCount; i++) {
+            if (_outputs[i].slot == slot) return &_outputs[i];
+        }
+        return NULL;
+    }
+    OutputModule* _findOutput(uint8_t slot) {
+        return const_cast<OutputModule*>(static_cast<const P1ProcessImage*>(this)->_findOutput(slot));
+    }
+};
+
+#endif // P1_PROCESS_IMAGE_H
@@ -1,14 +1,16 @@
 #include <Arduino.h>
 #include <P1AM.h>
+#include "P1ProcessImage.h"
+#include "ColorClassifier.h"
+#include "LineMonitor.h"
 
-enum MachineStates {
-  Waiting,
-  ColorSensing,
-  CountedMove,
-  ejectState
+// Ejector: a timed state, released by deadline instead of delay()
+enum EjectorStates {
+  EjectorIdle,
+  Ejecting
 };
 
-MachineStates curState = Waiting;
+EjectorStates ejectorState = EjectorIdle;
 
 // Modules
 int modInput = 1;
@@ -27,16 +29,49 @@ int ejectW = 3;
 int ejectR = 4;
 int ejectB = 5;
 
+// Discrete I/O is read once at the start of each scan and written once at the end
+P1ProcessImage io;
+
 // Analog Inputs
 int color = 1;
 
+// Colour sampled every 2 ms, averaged in blocks of 4; thresholds adapt from confirmed sorts
+ColorClassifier classifier(2000, 4);
+const char colorNames[CLASSIFIER_CLASSES] = {'w', 'r', 'b'};
+const int ejectDist[CLASSIFIER_CLASSES] = {3, 9, 15}; // pulses from lbOut to each ejector
+
+// Shift-register style tracker: every part on the belt, oldest first. A part is added
+// when it trips lbIn and takes the colour samples until it passes lbOut. There it is
+// classified and given the absolute pulse index at which it reaches its ejector.
+#define MAX_PARTS 8
+
+struct PartRecord {
+  ColorClassifier::Window window; // colour samples while between the barriers
+  int feature;            // classifier feature, fixed at lbOut
+  unsigned long ejectAt;  // pulseCount at which the part is in front of its ejector
+  uint8_t colorClass;
+  uint16_t number;        // part number for the monitor's event log
+  uint32_t enteredAt;     // micros() at lbIn
+  uint32_t phaseAt;       // micros() at the start of the current phase
+  bool classified;        // passed lbOut, feature, ejectAt and colorClass are valid
+};
+
+PartRecord parts[MAX_PARTS];
+uint8_t partCount = 0;
+unsigned long pulseCount = 0; // pulse key edges since power up, the belt position
+
+// Phase timing and throughput, reported on the serial port
+LineMonitor monitor;
+uint16_t partNumber = 0;  // last part number handed out
+bool lineEmpty = true;    // no part tracked and no ejection running
+uint32_t emptySince = 0;
+
 // Vars
-int colorValue = 10000;
-int distToEject = 0;
-int distMoved = 0;
-bool prevKeyState = false;
-bool curKey = false;
-char targetColor = 'b';
+unsigned long ejectTime = 1500; // ms the ejector valve stays open
+unsigned long ejectEnd = 0;     // millis() deadline of the current ejection
+int ejectPin = 0;
+uint16_t ejectPart = 0;         // part number being ejected
+uint32_t ejectStart = 0;        // micros() when the valve opened
 
 void setup() {
   delay(1000);
@@ -46,101 +81,187 @@ void setup() {
   while(!P1.init()) {
     delay(1);
   }
-  
-}
-
-bool InputTriggered() {
-  return !P1.readDiscrete(modInput, lbIn);
-}
+  io.addInputModule(modInput);
+  io.addOutputModule(modOutput);
 
-bool OutputTriggered() {
-  return !P1.readDiscrete(modInput, lbOut);
+  monitor.reset();
+  emptySince = micros();
 }
 
 void ToggleConveyor(bool s) {
-  P1.writeDiscrete(s, modOutput, conv);
+  io.setOutput(modOutput, conv, s);
 }
 
 int GetColor() {
   return P1.readAnalog(modAnalog, color);
 }
 
-bool GetPulseKey() {
-  return P1.readDiscrete(modInput, pulse);
-}
-
 void ToggleCompressor(bool s) {
-  P1.writeDiscrete(s, modOutput, compressor);
+  io.setOutput(modOutput, compressor, s);
 }
 
-void UseEjector(char c) {
-  int tempPin;
+// Open the ejector for part p; it is closed by UpdateEjector() once the deadline passes.
+void StartEjector(const PartRecord &p) {
+  char c = colorNames[p.colorClass];
   if (c == 'w') {
-    tempPin = ejectW;
+    ejectPin = ejectW;
   } else if (c == 'r') {
-    tempPin = ejectR;
+    ejectPin = ejectR;
   } else {
-    tempPin = ejectB;
+    ejectPin = ejectB;
   }
-  P1.writeDiscrete(true, modOutput, tempPin);
-  delay(1500);
-  P1.writeDiscrete(false, modOutput, tempPin);
+  io.setOutput(modOutput, ejectPin, true);
+  ejectEnd = millis() + ejectTime;
+  ejectorState = Ejecting;
+
+  ejectPart = p.number;
+  ejectStart = monitor.mark(LineMonitor::EVENT_EJECT, p.number, p.colorClass);
+  monitor.phaseDone(LineMonitor::PHASE_TRAVEL, ejectStart - p.phaseAt);
+  monitor.phaseDone(LineMonitor::PHASE_PART, ejectStart - p.enteredAt);
+  monitor.sorted(p.colorClass);
 }
 
-void loop() {
-  
-  switch (curState)
-  {
-  case Waiting:
-    // Wait for light barrier to be tripped
-    // After tripped, switch state and turn on conveyor
-    if (InputTriggered()) {
-      curState = ColorSensing;
-      ToggleConveyor(true);
-      colorValue = 10000;
-    }
-    break;
-  case ColorSensing:
-    // Get color and find min 
-    colorValue = min(GetColor(), colorValue);
-    // Keep on going until second light barrier
-    // Then switch states
-    if (OutputTriggered()) {
-      curState = CountedMove;
-      distMoved = 0;
-      // Decide how far to move
-      if (colorValue < 2500) {
-        distToEject = 3;
-        targetColor = 'w';
-      } else if (colorValue < 4600) {
-        distToEject = 9;
-        targetColor = 'r';
-      } else {
-        distToEject = 15;
-        targetColor = 'b';
-      }
-      ToggleCompressor(true);
-    }
-    
-  break;
-  case CountedMove:
-    // Watch pulse key to move that far
-    curKey = GetPulseKey();
-    if (curKey && !prevKeyState) {
-      distMoved++;
+void UpdateEjector() {
+  if (ejectorState == Ejecting && (long)(millis() - ejectEnd) >= 0) {
+    io.setOutput(modOutput, ejectPin, false);
+    ejectorState = EjectorIdle;
+    uint32_t now = monitor.mark(LineMonitor::EVENT_RELEASE, ejectPart);
+    monitor.phaseDone(LineMonitor::PHASE_EJECT, now - ejectStart);
+  }
+}
+
+bool PushPart() {
+  if (partCount >= MAX_PARTS) return false;
+  PartRecord &p = parts[partCount++];
+  p.window.reset();
+  p.feature = ColorClassifier::NO_FEATURE;
+  p.ejectAt = 0;
+  p.colorClass = 0;
+  p.number = ++partNumber;
+  p.enteredAt = monitor.mark(LineMonitor::EVENT_ENTER, p.number);
+  p.phaseAt = p.enteredAt;
+  p.classified = false;
+  return true;
+}
+
+// Remove the i-th part (0 = oldest), keeping the others in order
+void RemovePart(uint8_t i) {
+  for (; i + 1 < partCount; i++) {
+    parts[i] = parts[i + 1];
+  }
+  partCount--;
+}
+
+// Parts keep their order on the belt, so the oldest unclassified part is the one
+// between the barriers nearest lbOut. It takes every colour sample, so parts need to be
+// spaced so the next one is not under the sensor before it reaches lbOut.
+// Returns partCount if there is none.
+uint8_t SensingPart() {
+  uint8_t i = 0;
+  while (i < partCount && parts[i].classified) i++;
+  return i;
+}
+
+// Give part p its colour and the pulse index of its ejector. A part that passed the
+// sensor without a single sample goes to the last ejector.
+void ClassifyPart(PartRecord &p) {
+  p.feature = classifier.feature(p.window);
+  p.colorClass = p.window.samples ? classifier.classify(p.feature) : CLASSIFIER_CLASSES - 1;
+  p.ejectAt = pulseCount + ejectDist[p.colorClass];
+  p.classified = true;
+
+  uint32_t now = monitor.mark(LineMonitor::EVENT_CLASSIFY, p.number, p.colorClass);
+  monitor.phaseDone(LineMonitor::PHASE_SENSING, now - p.phaseAt);
+  p.phaseAt = now;
+}
+
+// Barrier edges (active low, so a part arriving is a falling edge) add parts and
+// classify them; the colour input is only read, at the classifier's sample rate, while
+// a part is between the barriers.
+void UpdateSensing() {
+  if (io.fell(modInput, lbIn)) {
+    if (!PushPart()) {
+      monitor.mark(LineMonitor::EVENT_LOST, ++partNumber);
+      Serial.println("Too many parts on the belt, part not tracked");
     }
-    prevKeyState = curKey;
-    // Switch states and turn off conveyor
-    if (distMoved >= distToEject) {
-      curState = ejectState;
-      ToggleConveyor(false);
+  }
+  uint8_t i = SensingPart();
+  if (i < partCount && io.fell(modInput, lbOut)) {
+    ClassifyPart(parts[i]);
+    ToggleCompressor(true);
+    i = SensingPart();
+  }
+  // Classify before sampling: once a part is at lbOut the sensor may already see the next one
+  if (i < partCount && classifier.sampleDue(micros())) {
+    classifier.addSample(parts[i].window, GetColor());
+  }
+}
+
+// One counter for the whole belt: each pulse key edge moves every part one pulse on.
+// A part is ejected when the counter reaches its index; a younger part bound for a
+// nearer ejector can be due before an older one, so every record is checked. The belt
+// stops while an ejector is open.
+void UpdateParts() {
+  if (io.rose(modInput, pulse)) {
+    pulseCount++;
+  }
+  if (ejectorState != EjectorIdle) return;
+  for (uint8_t i = 0; i < partCount; i++) {
+    PartRecord &p = parts[i];
+    if (p.classified && (long)(pulseCount - p.ejectAt) >= 0) {
+      StartEjector(p);
+      // Reaching its ejector is the only confirmation the line has
+      classifier.confirm(p.colorClass, p.feature);
+      RemovePart(i);
+      break;
     }
-  break;
-  case ejectState:
-    UseEjector(targetColor);
-    curState = Waiting;
-  break;
-  default:
-    break;
   }
 }
+
+// Time the line spends with nothing on it is the idle phase
+void UpdateIdle() {
+  bool empty = partCount == 0 && ejectorState == EjectorIdle;
+  if (empty == lineEmpty) return;
+  lineEmpty = empty;
+  uint32_t now = micros();
+  if (empty) {
+    emptySince = now;
+  } else {
+    monitor.phaseDone(LineMonitor::PHASE_IDLE, now - emptySince);
+  }
+}
+
+// Serial commands: 's' classifier statistics, 't' phase timing and parts per minute,
+// 'e' the recent transitions, 'r' restart the timing statistics. Commands wait in the
+// serial buffer while a report is still being written.
+void HandleSerial() {
+  if (monitor.reporting() || !Serial.available()) return;
+  char c = Serial.read();
+  if (c == 's') {
+    classifier.printStats(Serial);
+  } else if (c == 't') {
+    monitor.requestSummary();
+  } else if (c == 'e') {
+    monitor.requestEvents();
+  } else if (c == 'r') {
+    monitor.reset();
+  }
+}
+
+void loop() {
+  monitor.scan();
+  io.readInputs();
+
+  UpdateEjector();
+  UpdateSensing();
+  UpdateParts();
+  UpdateIdle();
+
+  // Belt runs while any part is on it, except during an ejection
+  ToggleConveyor(ejectorState == EjectorIdle && partCount > 0);
+
+  io.writeOutputs();
+
+  HandleSerial();
+  monitor.update(Serial);
+}
@@ -1,48 +1,252 @@
 #ifndef MOTOR_ENCODER_H
 #define MOTOR_ENCODER_H
-#endif
+
+// MotorEncoder.h
+// DC motor with a single-channel pulse encoder, driven through P1AM discrete modules.
+//
+// Pulses can be counted three ways:
+//  - polled: UpdatePulse() is called from loop() (MoveTo() does this). Edges are lost
+//    whenever loop() is slow, e.g. during delay().
+//  - sampled: BeginSampler() registers the encoder with a shared timer interrupt that
+//    reads each input module once per tick (one bulk transaction for all encoders on
+//    the module) and counts rising edges, however long loop() takes.
+//  - interrupt: BeginInterrupt(pin) counts edges on a MCU pin wired to the encoder.
+//
+// The sampler shares the P1 bus with the foreground. Every P1 transfer issued from the
+// foreground runs with interrupts disabled, so a tick can never start a transfer in the
+// middle of another one: it stays pending and runs as soon as the transfer is done,
+// late by one transaction at most.
+//
+// Sampling can miss edges if the pulse rate gets close to the sample rate, so the
+// encoder keeps an overrun counter: it counts ticks that ran more than half a period
+// late and encoder phases that lasted only a single sample. A non-zero GetOverruns()
+// means the sample rate is too low for the motor speed.
+//
+// Motor outputs are kept in a per-module image and written only when a direction changes,
+// one whole-module transaction per change.
+//
+// Homing is a resumable state machine (StartHoming() / UpdateHoming()): a full-power
+// seek onto the limit switch, a back-off until the switch opens plus a few pulses, then
+// a slow re-seek. The motor only switches on and off, so the re-seek is slow by duty
+// cycle: short power bursts separated by coasting. Home() runs the same sequence blocking.
 
 #include <Arduino.h>
 #include <P1AM.h>
 
+#ifndef ENCODER_MAX
+#define ENCODER_MAX 4 // encoders that can use the sampler or interrupt backends
+#endif
+
+#ifndef ENCODER_SAMPLE_HZ
+#define ENCODER_SAMPLE_HZ 2000UL
+#endif
+
+#ifndef ENCODER_HOME_BACKOFF
+#define ENCODER_HOME_BACKOFF 4    // pulses past the switch opening before the re-seek
+#endif
+#ifndef ENCODER_HOME_BURST_MS
+#define ENCODER_HOME_BURST_MS 15  // re-seek: power on this long...
+#endif
+#ifndef ENCODER_HOME_COAST_MS
+#define ENCODER_HOME_COAST_MS 60  // ...then coast this long
+#endif
+
 class MotorEncoder {
+public:
+    enum HomingState {
+        HOMING_IDLE = 0,
+        HOMING_SEEK,    // full power towards the switch
+        HOMING_BACKOFF, // away from the switch until it opens, plus ENCODER_HOME_BACKOFF
+        HOMING_RESEEK,  // power bursts back onto the switch
+        HOMING_DONE,
+        HOMING_FAILED   // timed out
+    };
+
 private:
     int modInput;
     int modOutput;
     int pinCw;
     int pinCcw;
     int pinEncoder;
-    int pulseCount;
-    bool prevState;
-    int dir;
+    volatile int pulseCount;
+    volatile bool prevState;
+    volatile int dir;
     int pinLimitSwitch;
+    uint8_t backend;
+    int8_t outputState; // last direction written to the outputs (1, -1, 0), -2 = unknown
+    volatile unsigned long overruns;
+    volatile uint16_t phaseSamples; // samples since the last level change
+    volatile uint32_t inputBits;    // last sampled input module image
+    uint8_t homeState;
+    unsigned long homeStart;
+    unsigned long homeTimeout;
+    unsigned long homeBurstAt;      // re-seek: start of the current burst/coast cycle
+    int homeBackoffFrom;
+
+    enum { BACKEND_POLL, BACKEND_SAMPLER, BACKEND_INTERRUPT };
+
+    static MotorEncoder** registry() {
+        static MotorEncoder* encoders[ENCODER_MAX] = {};
+        return encoders;
+    }
+    static volatile unsigned long& lastSampleMicros() {
+        static volatile unsigned long last = 0;
+        return last;
+    }
+    // Output image of each output module shared by all encoders, so a direction change
+    // is a single whole-module write. Assumes the encoders own their output modules.
+    static uint32_t& outputImage(uint8_t slot) {
+        static uint32_t images[16] = {};
+        return images[slot & 15];
+    }
+    static unsigned long& samplePeriodMicros() {
+        static unsigned long period = 1000000UL / ENCODER_SAMPLE_HZ;
+        return period;
+    }
+
+    bool enroll(uint8_t mode, int8_t& slot) {
+        MotorEncoder** encoders = registry();
+        for (uint8_t i = 0; i < ENCODER_MAX; i++) {
+            if (encoders[i] == NULL || encoders[i] == this) {
+                noInterrupts();
+                encoders[i] = this;
+                backend = mode;
+                interrupts();
+                slot = (int8_t)i;
+                return true;
+            }
+        }
+        slot = -1;
+        return false;
+    }
+
+    // Foreground P1 transfers: hold off the sampler tick until the transfer is done
+    static void lockBus() { noInterrupts(); }
+    static void unlockBus() { interrupts(); }
+
+    // Only touches the bus when the direction actually changes
+    void writeOutputs(bool cw, bool ccw) {
+        int8_t state = cw ? 1 : (ccw ? -1 : 0);
+        if (state == outputState) return;
+        outputState = state;
+        uint32_t& image = outputImage(modOutput);
+        image &= ~((1UL << (pinCw - 1)) | (1UL << (pinCcw - 1)));
+        if (cw) image |= 1UL << (pinCw - 1);
+        if (ccw) image |= 1UL << (pinCcw - 1);
+        lockBus();
+        P1.writeDiscrete(image, modOutput); // channel 0: whole module in one transaction
+        unlockBus();
+    }
+
+    // Feed one sampled level (sampler backend, interrupt context)
+    void sample(bool currentState) {
+        if (currentState != prevState) {
+            if (phaseSamples <= 1) overruns++; // phase shorter than two samples: edges may be lost
+            if (currentState) pulseCount += dir;
+            prevState = currentState;
+            phaseSamples = 1;
+        } else if (phaseSamples < 0xFFFF) {
+            phaseSamples++;
+        }
+    }
+
+    template <uint8_t N>
+    static void edgeIsr() {
+        MotorEncoder* e = registry()[N];
+        if (e) e->pulseCount += e->dir;
+    }
 
 public:
-    MotorEncoder(int mInput, int mOutput, int pCw, int pCcw, int pE, int sw ): modInput(mInput), modOutput(mOutput), pinCw(pCw), pinCcw(pCcw), pinEncoder(pE), pulseCount(0), prevState(false), dir(1), pinLimitSwitch(sw) {;}
+    MotorEncoder(int mInput, int mOutput, int pCw, int pCcw, int pE, int sw ): modInput(mInput), modOutput(mOutput), pinCw(pCw), pinCcw(pCcw), pinEncoder(pE), pulseCount(0), prevState(false), dir(1), pinLimitSwitch(sw), backend(BACKEND_POLL), outputState(-2), overruns(0), phaseSamples(0xFFFF), inputBits(0), homeState(HOMING_IDLE), homeStart(0), homeTimeout(0), homeBurstAt(0), homeBackoffFrom(0) {;}
 
+    // Polled counting (UpdatePulse() from loop())
     void begin() {
-        //instance = this;
+        backend = BACKEND_POLL;
+    }
+
+    // Count from the shared timer sampler. Call StartSampler() once after the encoders.
+    bool BeginSampler() {
+        int8_t slot;
+        return enroll(BACKEND_SAMPLER, slot);
+    }
+
+    // Count rising edges on a MCU pin with an external interrupt.
+    bool BeginInterrupt(uint8_t pin) {
+        int8_t slot;
+        if (!enroll(BACKEND_INTERRUPT, slot)) return false;
+        static void (*const isrs[])(void) = { edgeIsr<0>, edgeIsr<1>, edgeIsr<2>, edgeIsr<3> };
+        if (slot >= (int8_t)(sizeof(isrs) / sizeof(isrs[0]))) return false;
+        pinMode(pin, INPUT);
+        attachInterrupt(digitalPinToInterrupt(pin), isrs[slot], RISING);
+        return true;
+    }
+
+    // Start the periodic sampler for every encoder registered with BeginSampler().
+    static void StartSampler(unsigned long rateHz = ENCODER_SAMPLE_HZ) {
+        samplePeriodMicros() = 1000000UL / rateHz;
+        lastSampleMicros() = micros();
+#if defined(ARDUINO_ARCH_SAMD)
+        // TC5 in match-frequency mode from the 48 MHz GCLK0, /16 prescaler
+        GCLK->CLKCTRL.reg = (uint16_t)(GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_ID(GCM_TC4_TC5));
+        while (GCLK->STATUS.bit.SYNCBUSY);
+        TC5->COUNT16.CTRLA.reg = TC_CTRLA_SWRST;
+        while (TC5->COUNT16.STATUS.bit.SYNCBUSY);
+        while (TC5->COUNT16.CTRLA.bit.SWRST);
+        TC5->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_WAVEGEN_MFRQ | TC_CTRLA_PRESCALER_DIV16;
+        TC5->COUNT16.CC[0].reg = (uint16_t)(SystemCoreClock / 16 / rateHz - 1);
+        while (TC5->COUNT16.STATUS.bit.SYNCBUSY);
+        NVIC_EnableIRQ(TC5_IRQn);
+        TC5->COUNT16.INTENSET.bit.MC0 = 1;
+        TC5->COUNT16.CTRLA.reg |= TC_CTRLA_ENABLE;
+        while (TC5->COUNT16.STATUS.bit.SYNCBUSY);
+#elif defined(NATIVE_HAL)
+        hal::every(samplePeriodMicros(), SampleAll);
+#endif
+    }
+
+    // Timer interrupt body: one bulk read per input module, then edge detection per
+    // encoder. Runs with interrupts disabled, so no foreground transfer is in progress.
+    static void SampleAll() {
+        MotorEncoder** encoders = registry();
+        unsigned long now = micros();
+        bool late = (now - lastSampleMicros()) > samplePeriodMicros() + samplePeriodMicros() / 2;
+        lastSampleMicros() = now;
+
+        int lastMod = -1;
+        uint32_t bits = 0;
+        for (uint8_t i = 0; i < ENCODER_MAX; i++) {
+            MotorEncoder* e = encoders[i];
+            if (e == NULL || e->backend != BACKEND_SAMPLER) continue;
+            if (late) e->overruns++;
+            if (e->modInput != lastMod) {
+                bits = P1.readDiscrete(e->modInput); // all channels, bit 0 = channel 1
+                lastMod = e->modInput;
+            }
+            e->inputBits = bits;
+            e->sample((bits >> (e->pinEncoder - 1)) & 1);
+        }
     }
 
     void MoveCw () {
-        P1.writeDiscrete(true, modOutput, pinCw);
-        P1.writeDiscrete(false, modOutput, pinCcw);
+        writeOutputs(true, false);
         dir = 1;
     }
 
     void MoveCcw () {
-        P1.writeDiscrete(true, modOutput, pinCcw);
-        P1.writeDiscrete(false, modOutput, pinCw);
+        writeOutputs(false, true);
         dir = -1;
     }
 
     void Stop() {
-        P1.writeDiscrete(false, modOutput, pinCcw);
-        P1.writeDiscrete(false, modOutput, pinCw);
+        writeOutputs(false, false);
     }
 
+    // Polled edge detection; no-op when a sampler or interrupt backend is counting.
     void UpdatePulse() {
+        if (backend != BACKEND_POLL) return;
+        lockBus();
         bool currentState = P1.readDiscrete(modInput, pinEncoder);
+        unlockBus();
         if (currentState && !prevState) {
             pulseCount += dir;
         }
@@ -50,26 +254,110 @@ public:
     }
 
     void ZeroPulse() {
+        noInterrupts();
         pulseCount = 0;
+        interrupts();
     }
 
     int GetPulseCount() {
-        return pulseCount;
+        noInterrupts();
+        int count = pulseCount;
+        interrupts();
+        return count;
+    }
+
+    // Late samples and single-sample encoder phases (sampler backend)
+    unsigned long GetOverruns() {
+        noInterrupts();
+        unsigned long count = overruns;
+        interrupts();
+        return count;
+    }
+
+    // The sampler already reads the limit switch's module, so with that backend the
+    // switch is taken from the last sample instead of another bus transaction.
+    bool LimitSwitchClosed() {
+        if (backend == BACKEND_SAMPLER) return (inputBits >> (pinLimitSwitch - 1)) & 1;
+        lockBus();
+        bool closed = P1.readDiscrete(modInput, pinLimitSwitch);
+        unlockBus();
+        return closed;
     }
 
-    void Home() {
-        while (!P1.readDiscrete(modInput, pinLimitSwitch)) { 
-            MoveCcw(); 
+    // Start homing; call UpdateHoming() until it returns HOMING_DONE or HOMING_FAILED.
+    // timeoutMs = 0 waits forever.
+    void StartHoming(unsigned long timeoutMs = 0) {
+        homeStart = millis();
+        homeTimeout = timeoutMs;
+        homeState = HOMING_SEEK;
+        MoveCcw();
+    }
+
+    HomingState UpdateHoming() {
+        if (homeState == HOMING_IDLE || homeState >= HOMING_DONE) return (HomingState)homeState;
+        unsigned long now = millis();
+        if (homeTimeout && (now - homeStart) >= homeTimeout) {
+            Stop();
+            homeState = HOMING_FAILED;
+            return HOMING_FAILED;
+        }
+        UpdatePulse();
+        bool closed = LimitSwitchClosed();
+        switch (homeState) {
+        case HOMING_SEEK:
+            if (!closed) break;
+            MoveCw();
+            homeBackoffFrom = GetPulseCount();
+            homeState = HOMING_BACKOFF;
+            break;
+        case HOMING_BACKOFF:
+            if (closed) { homeBackoffFrom = GetPulseCount(); break; }
+            if (GetPulseCount() - homeBackoffFrom < ENCODER_HOME_BACKOFF) break;
+            Stop();
+            homeBurstAt = now - ENCODER_HOME_BURST_MS - ENCODER_HOME_COAST_MS; // coast first
+            homeState = HOMING_RESEEK;
+            break;
+        case HOMING_RESEEK: {
+            if (closed) {
+                Stop();
+                ZeroPulse();
+                homeState = HOMING_DONE;
+                break;
+            }
+            unsigned long t = now - homeBurstAt;
+            if (t >= ENCODER_HOME_BURST_MS + ENCODER_HOME_COAST_MS) {
+                homeBurstAt = now;
+                MoveCcw();
+            } else if (t >= ENCODER_HOME_BURST_MS) {
+                Stop();
+            }
+            break;
+        }
+        default:
+            break;
         }
-        Stop();
-        ZeroPulse();
+        return (HomingState)homeState;
+    }
+
+    bool IsHoming() const { return homeState > HOMING_IDLE && homeState < HOMING_DONE; }
+    HomingState GetHomingState() const { return (HomingState)homeState; }
+
+    // Blocking homing. Returns false on timeout.
+    bool Home(unsigned long timeoutMs = 0) {
+        StartHoming(timeoutMs);
+        while (IsHoming()) {
+            UpdateHoming();
+            yield();
+        }
+        return homeState == HOMING_DONE;
     }
 
     bool MoveTo(int targetPos) {
         UpdatePulse();
-        if (pulseCount < targetPos ) {
+        int count = GetPulseCount();
+        if (count < targetPos ) {
             MoveCw();
-        } else if (pulseCount > targetPos ) {
+        } else if (count > targetPos ) {
             MoveCcw();
         } else {
             Stop();
@@ -77,4 +365,14 @@ public:
         }
         return false;
     }
-};
\ No newline at end of file
+};
+
+#if defined(ARDUINO_ARCH_SAMD)
+// Encoder sampler tick. Include this header from a single translation unit only.
+void TC5_Handler() {
+    TC5->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+    MotorEncoder::SampleAll();
+}
+#endif
+
+#endif // MOTOR_ENCODER_H
@@ -0,0 +1,295 @@
+#ifndef TRAJECTORY_SCHEDULER_H
+#define TRAJECTORY_SCHEDULER_H
+
+// TrajectoryScheduler.h
+// Coordinated waypoint tour for MotorEncoder axes (the camera pan/tilt).
+//
+// The motors are switched on and off through discrete outputs, so an axis cannot be
+// slowed down, only started later or stopped earlier:
+//  - Synchronised arrival: each axis keeps a measured cruise speed (pulses/s). For a
+//    waypoint the longest travel time sets the move time, and every other axis starts
+//    late by the difference, so all axes arrive together.
+//  - Coasting approach: a motor keeps turning for a while after it is switched off. Each
+//    axis keeps the measured coast distance and cuts power that many pulses before the
+//    target, so it coasts onto it instead of overshooting and reversing. A remaining
+//    error larger than the tolerance is taken out with short jogs, which learn their own
+//    (shorter) coast.
+//  - Dwell: the observation time at each waypoint is a millis() deadline; update()
+//    never blocks.
+//  - Timeout: a drive that runs longer than its travel at the learned speed, times
+//    TRAJ_TIMEOUT_SCALE plus TRAJ_TIMEOUT_MARGIN_MS, is stopped (a stalled motor, a lost
+//    encoder). That axis gives up on the waypoint without learning from the move, and
+//    lastFailed() reports the waypoint as failed when the tour arrives.
+//
+// Call update() from every loop() pass. Encoders should count from the sampler or an
+// interrupt so the count keeps up while loop() does other work.
+
+#include <Arduino.h>
+#include "MotorEncoder.h"
+
+#ifndef TRAJ_MAX_AXES
+#define TRAJ_MAX_AXES 2
+#endif
+
+#ifndef TRAJ_MAX_WAYPOINTS
+#define TRAJ_MAX_WAYPOINTS 8
+#endif
+
+#define TRAJ_SETTLE_MS 60      // count unchanged this long = motor stopped
+#define TRAJ_MAX_JOGS 3        // correction jogs per waypoint before accepting the error
+#define TRAJ_LEARN_MIN_MS 250  // drive time a move needs before it updates the speed/coast
+
+#ifndef TRAJ_TIMEOUT_SCALE
+#define TRAJ_TIMEOUT_SCALE 2.0f    // drive time limit, in expected travel times
+#endif
+
+#ifndef TRAJ_TIMEOUT_MARGIN_MS
+#define TRAJ_TIMEOUT_MARGIN_MS 500 // added to the limit for start-up and short jogs
+#endif
+
+class TrajectoryScheduler {
+public:
+    struct Waypoint {
+        int target[TRAJ_MAX_AXES];
+        unsigned long dwellMs;
+    };
+
+    TrajectoryScheduler()
+        : _axisCount(0), _waypointCount(0), _current(0), _state(STATE_IDLE),
+          _moveStart(0), _dwellEnd(0), _arrived(false), _lastMoveMs(0), _lastSkewMs(0),
+          _lastFailed(false) {}
+
+    // Add an axis with a first guess of its speed (pulses/s) and coast (pulses). Both are
+    // refined from every long enough move. `tolerance` is the accepted final error.
+    bool addAxis(MotorEncoder& motor, float pulsesPerSec, int coastPulses = 0, int tolerance = 1) {
+        if (_axisCount >= TRAJ_MAX_AXES) return false;
+        Axis& a = _axes[_axisCount++];
+        a.motor = &motor;
+        a.speed = pulsesPerSec > 1.0f ? pulsesPerSec : 1.0f;
+        a.coast = (float)coastPulses;
+        a.jogCoast = 0.0f;
+        a.tolerance = tolerance;
+        a.state = AXIS_DONE;
+        a.failed = false;
+        return true;
+    }
+
+    // Append a waypoint; targets has one entry per axis, in addAxis() order
+    bool addWaypoint(const int* targets, unsigned long dwellMs) {
+        if (_waypointCount >= TRAJ_MAX_WAYPOINTS) return false;
+        Waypoint& w = _waypoints[_waypointCount++];
+        for (uint8_t i = 0; i < TRAJ_MAX_AXES; i++) w.target[i] = (i < _axisCount) ? targets[i] : 0;
+        w.dwellMs = dwellMs;
+        return true;
+    }
+
+    // Run the tour from waypoint `index`, looping back to the first one at the end
+    void start(uint8_t index = 0) {
+        if (!_waypointCount) return;
+        _current = index % _waypointCount;
+        _state = STATE_PLAN;
+    }
+
+    void stop() {
+        for (uint8_t i = 0; i < _axisCount; i++) {
+            _axes[i].motor->Stop();
+            _axes[i].state = AXIS_DONE;
+        }
+        _state = STATE_IDLE;
+    }
+
+    void update() {
+        unsigned long now = millis();
+        switch (_state) {
+        case STATE_PLAN:
+            _plan(now);
+            _state = STATE_MOVE;
+            // fall through
+        case STATE_MOVE: {
+            bool done = true;
+            for (uint8_t i = 0; i < _axisCount; i++) {
+                _updateAxis(_axes[i], now);
+                if (_axes[i].state != AXIS_DONE) done = false;
+            }
+            if (done) {
+                unsigned long first = _axes[0].doneAt, last = _axes[0].doneAt;
+                for (uint8_t i = 1; i < _axisCount; i++) {
+                    if ((long)(_axes[i].doneAt - first) < 0) first = _axes[i].doneAt;
+                    if ((long)(_axes[i].doneAt - last) > 0) last = _axes[i].doneAt;
+                }
+                _lastMoveMs = now - _moveStart;
+                _lastSkewMs = last - first;
+                _lastFailed = false;
+                for (uint8_t i = 0; i < _axisCount; i++) _lastFailed |= _axes[i].failed;
+                _dwellEnd = now + _waypoints[_current].dwellMs;
+                _arrived = true;
+                _state = STATE_DWELL;
+            }
+            break;
+        }
+        case STATE_DWELL:
+            if ((long)(now - _dwellEnd) >= 0) {
+                _current = (_current + 1) % _waypointCount;
+                _state = STATE_PLAN;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    // True once after all axes have settled at a waypoint
+    bool arrived() {
+        bool a = _arrived;
+        _arrived = false;
+        return a;
+    }
+    bool dwelling() const { return _state == STATE_DWELL; }
+    uint8_t current() const { return _current; }
+
+    // Last move: time from start to the last axis settling, and spread of settle times
+    unsigned long lastMoveMs() const { return _lastMoveMs; }
+    unsigned long lastSkewMs() const { return _lastSkewMs; }
+    int lastError(uint8_t axis) const { return _axes[axis].target - _axes[axis].motor->GetPulseCount(); }
+    // Last waypoint was not reached: an axis drive ran into its timeout
+    bool lastFailed() const { return _lastFailed; }
+    bool failed(uint8_t axis) const { return _axes[axis].failed; }
+    float speed(uint8_t axis) const { return _axes[axis].speed; }
+    float coast(uint8_t axis) const { return _axes[axis].coast; }
+
+private:
+    enum { STATE_IDLE, STATE_PLAN, STATE_MOVE, STATE_DWELL };
+    enum { AXIS_WAIT, AXIS_DRIVE, AXIS_COAST, AXIS_DONE };
+
+    struct Axis {
+        MotorEncoder* motor;
+        float speed;     // measured cruise speed, pulses/s
+        float coast;     // measured pulses travelled after power off
+        float jogCoast;  // the same for short correction jogs, which never reach full speed
+        int tolerance;
+        int target;
+        uint8_t state;
+        int8_t dir;      // 1 = cw (count up), -1 = ccw
+        bool jog;        // correction move: uses and learns jogCoast only
+        bool failed;     // last drive timed out
+        uint8_t jogs;
+        unsigned long startAt;  // WAIT: millis() to power up
+        unsigned long driveStart;
+        unsigned long driveLimitMs; // DRIVE: power-on time before the drive times out
+        unsigned long drivenMs; // power-on time of the last drive
+        int driveStartCount;
+        unsigned long stopAt;   // COAST: last count change
+        int stopCount;
+        int lastCount;
+        unsigned long doneAt;
+    };
+
+    Axis _axes[TRAJ_MAX_AXES];
+    uint8_t _axisCount;
+    Waypoint _waypoints[TRAJ_MAX_WAYPOINTS];
+    uint8_t _waypointCount;
+    uint8_t _current;
+    uint8_t _state;
+    unsigned long _moveStart;
+    unsigned long _dwellEnd;
+    bool _arrived;
+    unsigned long _lastMoveMs;
+    unsigned long _lastSkewMs;
+    bool _lastFailed;
+
+    // Start times so every axis arrives with the slowest one
+    void _plan(unsigned long now) {
+        const Waypoint& w = _waypoints[_current];
+        float travel[TRAJ_MAX_AXES];
+        float longest = 0.0f;
+        for (uint8_t i = 0; i < _axisCount; i++) {
+            Axis& a = _axes[i];
+            a.target = w.target[i];
+            a.jogs = 0;
+            a.failed = false;
+            int distance = abs(a.target - a.motor->GetPulseCount());
+            travel[i] = distance > a.tolerance ? distance / a.speed * 1000.0f : 0.0f;
+            if (travel[i] > longest) longest = travel[i];
+        }
+        _moveStart = now;
+        for (uint8_t i = 0; i < _axisCount; i++) {
+            Axis& a = _axes[i];
+            if (travel[i] == 0.0f) {
+                a.state = AXIS_DONE;
+                a.doneAt = now + (unsigned long)longest; // counts as arriving on time
+                continue;
+            }
+            a.state = AXIS_WAIT;
+            a.jog = false;
+            a.startAt = now + (unsigned long)(longest - travel[i]);
+        }
+    }
+
+    void _drive(Axis& a, unsigned long now) {
+        int count = a.motor->GetPulseCount();
+        a.dir = (a.target > count) ? 1 : -1;
+        if (a.dir > 0) a.motor->MoveCw();
+        else a.motor->MoveCcw();
+        a.driveStart = now;
+        a.driveStartCount = count;
+        a.driveLimitMs = (unsigned long)(abs(a.target - count) / a.speed * 1000.0f * TRAJ_TIMEOUT_SCALE) +
+                         TRAJ_TIMEOUT_MARGIN_MS;
+        a.state = AXIS_DRIVE;
+    }
+
+    void _updateAxis(Axis& a, unsigned long now) {
+        int count = a.motor->GetPulseCount();
+        switch (a.state) {
+        case AXIS_WAIT:
+            if ((long)(now - a.startAt) >= 0) _drive(a, now);
+            break;
+        case AXIS_DRIVE: {
+            int remaining = (a.target - count) * a.dir;
+            float lead = a.jog ? a.jogCoast : a.coast;
+            a.drivenMs = now - a.driveStart;
+            if (remaining > lead && a.drivenMs > a.driveLimitMs) {
+                a.motor->Stop();
+                a.failed = true;
+                a.state = AXIS_DONE;
+                a.doneAt = now;
+                break;
+            }
+            if (remaining > lead) break;
+            a.motor->Stop();
+            if (!a.jog && a.drivenMs >= TRAJ_LEARN_MIN_MS) {
+                float measured = abs(count - a.driveStartCount) * 1000.0f / a.drivenMs;
+                a.speed += (measured - a.speed) * 0.5f;
+            }
+            a.stopCount = count;
+            a.lastCount = count;
+            a.stopAt = now;
+            a.state = AXIS_COAST;
+            break;
+        }
+        case AXIS_COAST: {
+            if (count != a.lastCount) {
+                a.lastCount = count;
+                a.stopAt = now;
+                break;
+            }
+            if (now - a.stopAt < TRAJ_SETTLE_MS) break;
+            float coasted = (float)((count - a.stopCount) * a.dir);
+            if (a.jog) a.jogCoast += (coasted - a.jogCoast) * 0.5f;
+            else if (a.drivenMs >= TRAJ_LEARN_MIN_MS) a.coast += (coasted - a.coast) * 0.5f;
+            if (abs(a.target - count) > a.tolerance && a.jogs < TRAJ_MAX_JOGS) {
+                a.jogs++;
+                a.jog = true;
+                _drive(a, now);
+            } else {
+                a.state = AXIS_DONE;
+                a.doneAt = a.stopAt;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+};
+
+#endif // TRAJECTORY_SCHEDULER_H
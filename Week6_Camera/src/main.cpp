@@ -1,6 +1,7 @@
 #include <Arduino.h>
 #include <P1AM.h>
 #include <MotorEncoder.h>
+#include "TrajectoryScheduler.h"
 
 //Move to observe the Processing Station Turntable, then observe it for 6 seconds
 //Move to observe the Sorting Line, then observe it for 4 seconds
@@ -15,12 +16,15 @@ int modAnalogIn = 3;
 int turnPos[] = {25, 80, 160, 240};
 int tiltPos[] = {30, 45, 60, 60};
 int obsDelay[] = {3000, 6000, 3000, 3000};
-int currentPos = 0;
 
 // MotorEncoder(int mInput, int mOutput, int pCw, int pCcw, int pE, int sw )
 MotorEncoder myFirstMotor(modInput, modOutput, 4, 3, 7, 2);
 MotorEncoder tiltMotor(modInput, modOutput, 1, 2, 5, 1);
 
+// Both axes start so they arrive together, coast onto the target and dwell without delay()
+TrajectoryScheduler tour;
+bool homing = true;
+
 void setup() {
   delay(1000);
   Serial.begin(9600);
@@ -30,14 +34,56 @@ void setup() {
     Serial.print("Waiting for connection...");
   }
   Serial.println("Connected!!!");
-  myFirstMotor.Home();
-  tiltMotor.Home();
+  // Count encoder pulses in the timer sampler's interrupt, so a slow loop() pass loses no edges
+  myFirstMotor.BeginSampler();
+  tiltMotor.BeginSampler();
+  MotorEncoder::StartSampler();
+  // Home both axes at once; loop() starts the tour when both are done
+  myFirstMotor.StartHoming(15000);
+  tiltMotor.StartHoming(15000);
+
+  // First guesses of speed (pulses/s) and coast (pulses); the tour measures both
+  tour.addAxis(myFirstMotor, 100, 0);
+  tour.addAxis(tiltMotor, 100, 0);
+  for (int i = 0; i < 4; i++) {
+    int target[] = {turnPos[i], tiltPos[i]};
+    tour.addWaypoint(target, obsDelay[i]);
+  }
 }
 
-void loop() { 
-  bool doneMoving = myFirstMotor.MoveTo(turnPos[currentPos]) & tiltMotor.MoveTo(tiltPos[currentPos]);
-  if (doneMoving) {
-    delay(obsDelay[currentPos]);
-    currentPos = (currentPos + 1) % 4; 
-  } 
+void loop() {
+  if (homing) {
+    myFirstMotor.UpdateHoming();
+    tiltMotor.UpdateHoming();
+    if (myFirstMotor.IsHoming() || tiltMotor.IsHoming()) return;
+    homing = false;
+    if (myFirstMotor.GetHomingState() != MotorEncoder::HOMING_DONE ||
+        tiltMotor.GetHomingState() != MotorEncoder::HOMING_DONE) {
+      myFirstMotor.Stop();
+      tiltMotor.Stop();
+      Serial.println("Homing failed");
+      return;
+    }
+    Serial.print("Homed after ");
+    Serial.print(millis());
+    Serial.println(" ms");
+    tour.start();
+  }
+  tour.update();
+  if (tour.arrived()) {
+    Serial.print(tour.lastFailed() ? "Timed out before position " : "At position ");
+    Serial.print(tour.current());
+    Serial.print(" after ");
+    Serial.print(tour.lastMoveMs());
+    Serial.print(" ms, skew ");
+    Serial.print(tour.lastSkewMs());
+    Serial.print(" ms, error ");
+    Serial.print(tour.lastError(0));
+    Serial.print(" / ");
+    Serial.print(tour.lastError(1));
+    Serial.print(", encoder overruns: ");
+    Serial.print(myFirstMotor.GetOverruns());
+    Serial.print(" / ");
+    Serial.println(tiltMotor.GetOverruns());
+  }
 }
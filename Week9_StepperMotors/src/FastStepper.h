@@ -0,0 +1,164 @@
+// FastStepper.h
+// Stepper with its pins fixed at compile time.
+//
+// FastStepper<STEP, DIR, MIN, MAX, EN> runs the same motion code as Stepper, but every
+// pin is a template parameter:
+//  - With -D FAST_STEPPER_PORTS=1 on the ATmega328P (Uno/Nano) the pins resolve to their
+//    PORTx/PINx registers at compile time, so a step pulse or a dir change is a single
+//    sbi/cbi instruction instead of a digitalWrite() table lookup.
+//  - In that mode the limit switches are watched by pin-change interrupts. The ISR stores
+//    the switch levels in a flag byte, and minPressed()/maxPressed() only read that byte,
+//    so the checks before and after every step cost almost nothing.
+// Without the flag (the default) FastStepper uses digitalRead()/digitalWrite() with
+// constant pins. The port path has not been run on hardware yet: [env:uno_ports] builds
+// the sketch with it and [env:uno_step_rate] measures the step rate of both paths.
+// test_fast_stepper_ports compiles it on the host against stand-in registers.
+//
+// This header defines the PCINT0..2 interrupt vectors on AVR, so include it from a single
+// translation unit only, and not together with a library that uses pin-change interrupts
+// itself (e.g. SoftwareSerial).
+
+#ifndef FAST_STEPPER_H
+#define FAST_STEPPER_H
+
+#include <Arduino.h>
+#include "Stepper.h"
+
+#ifndef FAST_STEPPER_PORTS
+#define FAST_STEPPER_PORTS 0 // direct port access, opt-in
+#endif
+
+#if FAST_STEPPER_PORTS && !defined(__AVR_ATmega328P__) && !defined(NATIVE_HAL)
+#error "FAST_STEPPER_PORTS needs an ATmega328P"
+#endif
+
+#ifndef FAST_STEPPER_MAX_SWITCH_SETS
+#define FAST_STEPPER_MAX_SWITCH_SETS 4 // FastStepper instances whose switches use PCINT
+#endif
+
+#if FAST_STEPPER_PORTS
+// ATmega328P pin P as port D (0-7), B (8-13) or C (14-19, A0-A5)
+template <uint8_t P>
+struct AvrPin {
+    static_assert(P <= 19, "FastStepper: pin is not on port B, C or D");
+    static volatile uint8_t& out() { return P < 8 ? PORTD : (P < 14 ? PORTB : PORTC); }
+    static volatile uint8_t& in() { return P < 8 ? PIND : (P < 14 ? PINB : PINC); }
+    static volatile uint8_t& ddr() { return P < 8 ? DDRD : (P < 14 ? DDRB : DDRC); }
+    static volatile uint8_t& pcmsk() { return P < 8 ? PCMSK2 : (P < 14 ? PCMSK0 : PCMSK1); }
+    static const uint8_t bit = 1 << (P < 8 ? P : (P < 14 ? P - 8 : P - 14));
+    static const uint8_t pcie = P < 8 ? PCIE2 : (P < 14 ? PCIE0 : PCIE1);
+
+    static void output() { ddr() |= bit; }
+    static void inputPullup() { ddr() &= ~bit; out() |= bit; }
+    static void write(bool high) {
+        if (high) out() |= bit;
+        else out() &= ~bit;
+    }
+    static bool read() { return (in() & bit) != 0; }
+    // Fire the PCINT vector of the pin's port on every level change
+    static void watch() {
+        pcmsk() |= bit;
+        PCIFR = 1 << pcie;
+        PCICR |= 1 << pcie;
+    }
+};
+
+// Refresh functions of every FastStepper with switches, called from the PCINT vectors
+struct FastStepperSwitches {
+    typedef void (*Refresh)();
+    static Refresh* list() {
+        static Refresh refreshers[FAST_STEPPER_MAX_SWITCH_SETS] = {};
+        return refreshers;
+    }
+    static void add(Refresh r) {
+        Refresh* l = list();
+        for (uint8_t i = 0; i < FAST_STEPPER_MAX_SWITCH_SETS; i++) {
+            if (l[i] == r) return;
+            if (l[i] == NULL) {
+                l[i] = r;
+                return;
+            }
+        }
+    }
+    static void refreshAll() {
+        Refresh* l = list();
+        for (uint8_t i = 0; i < FAST_STEPPER_MAX_SWITCH_SETS && l[i]; i++) l[i]();
+    }
+};
+#endif
+
+// Compile-time pin access for BasicStepper. MAX_PIN / EN_PIN = 0 means not connected.
+template <uint8_t STEP_PIN, uint8_t DIR_PIN, uint8_t MIN_PIN, uint8_t MAX_PIN = 0,
+          uint8_t EN_PIN = 0, bool ACTIVE_LOW = true>
+class FastStepperPins {
+public:
+#if FAST_STEPPER_PORTS
+    void begin() {
+        if (EN_PIN > 0) AvrPin<EN_PIN>::output();
+        AvrPin<STEP_PIN>::output();
+        AvrPin<DIR_PIN>::output();
+        AvrPin<MIN_PIN>::inputPullup();
+        if (MAX_PIN > 0) AvrPin<MAX_PIN>::inputPullup();
+        noInterrupts();
+        refresh();
+        FastStepperSwitches::add(refresh);
+        AvrPin<MIN_PIN>::watch();
+        if (MAX_PIN > 0) AvrPin<MAX_PIN>::watch();
+        interrupts();
+    }
+    void step(bool high) { AvrPin<STEP_PIN>::write(high); }
+    void dir(bool forward) { AvrPin<DIR_PIN>::write(forward); }
+    void enable(bool on) { if (EN_PIN > 0) AvrPin<EN_PIN>::write(!on); }
+    bool minPressed() const { return switches() & SWITCH_MIN; }
+    bool maxPressed() const { return switches() & SWITCH_MAX; }
+
+    // Re-read the switches (pin-change interrupt)
+    static void refresh() {
+        uint8_t s = 0;
+        if (AvrPin<MIN_PIN>::read() != ACTIVE_LOW) s |= SWITCH_MIN;
+        if (MAX_PIN > 0 && AvrPin<MAX_PIN>::read() != ACTIVE_LOW) s |= SWITCH_MAX;
+        switches() = s;
+    }
+#else
+    void begin() {
+        if (EN_PIN > 0) pinMode(EN_PIN, OUTPUT);
+        if (MAX_PIN > 0) pinMode(MAX_PIN, INPUT_PULLUP);
+        pinMode(STEP_PIN, OUTPUT);
+        pinMode(DIR_PIN, OUTPUT);
+        pinMode(MIN_PIN, INPUT_PULLUP);
+    }
+    void step(bool high) { digitalWrite(STEP_PIN, high ? HIGH : LOW); }
+    void dir(bool forward) { digitalWrite(DIR_PIN, forward ? HIGH : LOW); }
+    void enable(bool on) { if (EN_PIN > 0) digitalWrite(EN_PIN, on ? LOW : HIGH); }
+    bool minPressed() const { return (digitalRead(MIN_PIN) == HIGH) != ACTIVE_LOW; }
+    bool maxPressed() const { return MAX_PIN > 0 && (digitalRead(MAX_PIN) == HIGH) != ACTIVE_LOW; }
+#endif
+
+private:
+    enum { SWITCH_MIN = 1, SWITCH_MAX = 2 };
+
+    // One flag byte per pin combination, written by the pin-change interrupt
+    static volatile uint8_t& switches() {
+        static volatile uint8_t flags = 0;
+        return flags;
+    }
+};
+
+template <uint8_t STEP_PIN, uint8_t DIR_PIN, uint8_t MIN_PIN, uint8_t MAX_PIN = 0,
+          uint8_t EN_PIN = 0, bool ACTIVE_LOW = true>
+class FastStepper
+    : public BasicStepper<FastStepperPins<STEP_PIN, DIR_PIN, MIN_PIN, MAX_PIN, EN_PIN, ACTIVE_LOW> > {
+public:
+    typedef FastStepperPins<STEP_PIN, DIR_PIN, MIN_PIN, MAX_PIN, EN_PIN, ACTIVE_LOW> Pins;
+    FastStepper() : BasicStepper<Pins>(Pins()) {}
+};
+
+#if FAST_STEPPER_PORTS
+// A switch edge on any port refreshes every FastStepper's flags; edges are rare and
+// each refresh is a few port reads
+ISR(PCINT0_vect) { FastStepperSwitches::refreshAll(); }
+ISR(PCINT1_vect, ISR_ALIASOF(PCINT0_vect));
+ISR(PCINT2_vect, ISR_ALIASOF(PCINT0_vect));
+#endif
+
+#endif // FAST_STEPPER_H
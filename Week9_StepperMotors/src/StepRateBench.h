@@ -0,0 +1,67 @@
+#ifndef STEP_RATE_BENCH_H
+#define STEP_RATE_BENCH_H
+
+// StepRateBench.h
+// Highest step rate update() reaches, for Stepper (runtime pins, digitalWrite) and for
+// FastStepper on the same pins. The velocity is set so high that the step interval is 0
+// and every update() call steps, so the rate is the cost of one update() pass: the limit
+// check, the dir and step pin writes and the position update.
+//
+// On-target: build with -D STEP_RATE_BENCH=1 (env:uno_step_rate) and setup() prints the
+// two rates and their ratio over serial instead of starting the sketch. That env also
+// sets FAST_STEPPER_PORTS=1, so the FastStepper line is the direct port path; build it
+// without the flag to get the digitalWrite() fallback. Leave the switch pins open
+// (pulled up), or the limit check stops the motor.
+//
+// The port path becomes the default for env:uno once env:uno_ports builds with
+// -Werror and these numbers from an Uno are recorded.
+
+#include <Arduino.h>
+#include "Stepper.h"
+#include "FastStepper.h"
+
+#ifndef STEP_RATE_BENCH_MS
+#define STEP_RATE_BENCH_MS 1000UL // measuring time per stepper
+#endif
+
+namespace StepRateBench {
+
+// Steps per second with update() called back to back
+template <class S>
+unsigned long measure(S& stepper, unsigned long ms = STEP_RATE_BENCH_MS) {
+    stepper.begin();
+    stepper.enable();
+    stepper.setStepPulseWidth(0);
+    stepper.setPosition(0);
+    stepper.setVelocity(2000000.0f); // interval 0: step on every update()
+    unsigned long start = micros();
+    unsigned long now = start;
+    while (now - start < ms * 1000UL) {
+        now = micros();
+        stepper.update(now);
+    }
+    stepper.setVelocity(0.0f);
+    stepper.disable();
+    return (unsigned long)((uint64_t)labs(stepper.getPosition()) * 1000UL / ms);
+}
+
+// Pins of the sketch's x axis: step, dir, min switch, max switch, enable
+inline void run(Print& out) {
+    Stepper slow(5, 4, 3, 2, 12);
+    FastStepper<5, 4, 3, 2, 12> fast;
+    unsigned long before = measure(slow);
+    unsigned long after = measure(fast);
+
+    out.print(F("Stepper (digitalWrite): "));
+    out.print(before);
+    out.println(F(" steps/s"));
+    out.print(FAST_STEPPER_PORTS ? F("FastStepper (ports):    ") : F("FastStepper (digitalWrite): "));
+    out.print(after);
+    out.println(F(" steps/s"));
+    out.print(F("Speedup: x"));
+    out.println(before ? (float)after / before : 0.0f, 2);
+}
+
+} // namespace StepRateBench
+
+#endif // STEP_RATE_BENCH_H
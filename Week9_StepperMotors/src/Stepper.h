@@ -2,52 +2,125 @@
 // Stepper.h
 // Header-only Stepper motor helper for Arduino/PlatformIO
 // Put this file at: src/Stepper.h
+//
+// The motion logic lives in BasicStepper<Pins>, which does all of its pin I/O through
+// the Pins policy. Stepper uses StepperPins (pins chosen at run time, digitalRead/
+// digitalWrite). FastStepper.h provides the same class with the pins fixed at compile
+// time, for higher step rates.
 
 #ifndef STEPPER_H
 #define STEPPER_H
 
 #include <Arduino.h>
 
-class Stepper {
+// Run-time pin access. A pin number of 0 means "not connected" for the max switch and
+// the enable pin.
+class StepperPins {
 public:
-    // Constructor
-    Stepper(uint8_t stepPin, uint8_t dirPin,
-            uint8_t minSwitchPin, uint8_t maxSwitchPin = 0, uint8_t enablePin = 0,
-            bool switchesActiveLow = true)
-        : _enablePin(enablePin), _stepPin(stepPin), _dirPin(dirPin),
-          _minPin(minSwitchPin), _maxPin(maxSwitchPin),
-          _switchActiveLow(switchesActiveLow)
+    StepperPins(uint8_t stepPin, uint8_t dirPin, uint8_t minPin, uint8_t maxPin,
+                uint8_t enablePin, bool activeLow)
+        : _stepPin(stepPin), _dirPin(dirPin), _minPin(minPin), _maxPin(maxPin),
+          _enablePin(enablePin), _activeLow(activeLow) {}
+
+    void begin() {
+        if (_enablePin > 0) {pinMode(_enablePin, OUTPUT);}
+        if (_maxPin > 0) {pinMode(_maxPin, INPUT_PULLUP);}
+        pinMode(_stepPin, OUTPUT);
+        pinMode(_dirPin, OUTPUT);
+        pinMode(_minPin, INPUT_PULLUP);
+    }
+    void step(bool high) { digitalWrite(_stepPin, high ? HIGH : LOW); }
+    void dir(bool forward) { digitalWrite(_dirPin, forward ? HIGH : LOW); }
+    // Driver enable, active LOW
+    void enable(bool on) { if (_enablePin > 0) digitalWrite(_enablePin, on ? LOW : HIGH); }
+    bool minPressed() const { return _pressed(_minPin); }
+    bool maxPressed() const { return _maxPin > 0 && _pressed(_maxPin); }
+
+private:
+    uint8_t _stepPin, _dirPin, _minPin, _maxPin, _enablePin;
+    bool _activeLow;
+
+    bool _pressed(uint8_t pin) const {
+        bool val = digitalRead(pin);
+        return _activeLow ? (val == LOW) : (val == HIGH);
+    }
+};
+
+// Types shared by every stepper, whatever its pin access
+struct StepperBase {
+    // Speed profile used by moveTo() when an acceleration is set
+    enum Profile {
+        PROFILE_TRAPEZOID = 0, // constant acceleration
+        PROFILE_SCURVE         // acceleration ramps in and out (bounded jerk)
+    };
+
+    // Homing progress, advanced by update()
+    enum HomingState {
+        HOMING_IDLE = 0,
+        HOMING_SEEK,    // fast move towards the switch
+        HOMING_BACKOFF, // move off the switch until it releases, plus the back-off distance
+        HOMING_RESEEK,  // slow move back onto the switch, which sets the position
+        HOMING_DONE,
+        HOMING_FAILED   // timed out, or the switch did not release
+    };
+};
+
+template <class Pins>
+class BasicStepper : public StepperBase {
+public:
+
+    explicit BasicStepper(const Pins& pins) : _pins(pins)
     {
         _position = 0;
         _target = 0;
         _enabled = false;
         _direction = false; // true = forward / increasing position
+        _dirWritten = DIR_UNKNOWN;
         _velocity = 0.0f;
         _moveSpeed = 500.0f; // default steps/sec for moveTo/home
         _lastStepMicros = 0;
         _stepPulseMicros = 1;
         _autoMove = false;
+        _interval = 0;
+        _accel = 0.0f;
+        _profile = PROFILE_TRAPEZOID;
+        _phase = PHASE_IDLE;
+        _n = 0.0f;
+        _nMax = 0.0f;
+        _c = 0.0f;
+        _c0 = 0.0f;
+        _cMin = 0.0f;
+        _rampStep = 0;
+        _rampLength = 0.0f;
+        _rampN0 = 0.0f;
+        _profileForward = true;
+        _homeState = HOMING_IDLE;
+        _homeToMax = false;
+        _homeSetPosition = 0;
+        _homeStart = 0;
+        _homeTimeout = 0;
+        _homeSeekSpeed = 0.0f; // 0 = use _moveSpeed
+        _homeReseekSpeed = 0.0f; // 0 = an eighth of the seek speed
+        _homeBackoff = 40;
+        _homeBackoffFrom = 0;
     }
 
     // Call in setup()
     void begin() {
-        if (_enablePin > 0) {pinMode(_enablePin, OUTPUT);}
-        if (_maxPin > 0) {pinMode(_maxPin, INPUT_PULLUP);}
-        pinMode(_stepPin, OUTPUT);
-        pinMode(_dirPin, OUTPUT);
-        pinMode(_minPin, INPUT_PULLUP);
+        _pins.begin();
         disable();
-        digitalWrite(_stepPin, LOW);
+        _pins.step(false);
+        _dirWritten = DIR_UNKNOWN;
     }
 
     // Enable / disable driver (active LOW assumed)
     void enable() {
         _enabled = true;
-        digitalWrite(_enablePin, LOW);
+        _pins.enable(true);
     }
     void disable() {
         _enabled = false;
-        digitalWrite(_enablePin, HIGH);
+        _pins.enable(false);
     }
     bool isEnabled() const { return _enabled; }
 
@@ -56,38 +129,61 @@ public:
     bool stepOnce() {
         if (!_enabled) return false;
         if (!_canStepInDirection(_direction)) return false;
-        digitalWrite(_dirPin, _direction ? HIGH : LOW);
+        _writeDir(_direction);
         _pulseStep();
         _position += _direction ? 1 : -1;
         return true;
     }
 
     // Set direction: true = forward/increasing, false = reverse/decreasing
-    void setDirection(bool dir) { _direction = dir; digitalWrite(_dirPin, dir ? HIGH : LOW); }
+    void setDirection(bool dir) { _direction = dir; _writeDir(dir); }
     bool getDirection() const { return _direction; }
 
     // Continuous velocity in steps/sec (signed). Call update() frequently.
     // Positive = forward, Negative = reverse. 0 stops continuous motion.
     void setVelocity(float stepsPerSec) {
-        _velocity = stepsPerSec;
+        _setVelocity(stepsPerSec);
         _autoMove = false; // manual velocity overrides automatic moveTo state
+        _phase = PHASE_IDLE;
+    }
+    float getVelocity() const {
+        if (_phase == PHASE_IDLE || _c <= 0.0f) return _velocity;
+        return _profileForward ? 1000000.0f / _c : -1000000.0f / _c; // accelerated moveTo
     }
-    float getVelocity() const { return _velocity; }
 
     // Set speed (positive steps/sec) used by moveTo/home operations
-    void setMoveSpeed(float stepsPerSec) { _moveSpeed = fabs(stepsPerSec); }
+    void setMoveSpeed(float stepsPerSec) { _moveSpeed = fabs(stepsPerSec); _updateProfileLimits(); }
     float getMoveSpeed() const { return _moveSpeed; }
 
-    // Set step pulse width (microseconds)
+    // Acceleration (steps/sec^2) used by moveTo(). 0 (default) moves at constant speed
+    // with instant starts and stops.
+    void setAcceleration(float stepsPerSec2) { _accel = fabs(stepsPerSec2); _updateProfileLimits(); }
+    float getAcceleration() const { return _accel; }
+
+    // Trapezoidal (default) or S-curve ramps for accelerated moves.
+    void setProfile(Profile profile) { _profile = profile; }
+    Profile getProfile() const { return _profile; }
+
+    // Interval (microseconds) until the next step of an accelerated move
+    unsigned long getStepInterval() const { return (unsigned long)_c; }
+
+    // Set step pulse width (microseconds). 0 = no delay between the pin writes.
     void setStepPulseWidth(unsigned int microsPulse) { _stepPulseMicros = microsPulse; }
 
     // Non-blocking moveTo: sets a target position and update() will drive towards it.
     // Requires setMoveSpeed() (or keep default).
+    // With an acceleration set, the move ramps up and down and a new target may be given
+    // while moving (the motor decelerates first if it has to reverse).
     void moveTo(long position) {
         _target = position;
-        if (_target == _position) { _autoMove = false; _velocity = 0.0f; return; }
+        if (_accel > 0.0f) {
+            if (_target == _position && _phase == PHASE_IDLE) { _autoMove = false; _setVelocity(0.0f); return; }
+            _autoMove = true;
+            return;
+        }
+        if (_target == _position) { _autoMove = false; _setVelocity(0.0f); return; }
         _autoMove = true;
-        _velocity = (_target > _position) ? fabs(_moveSpeed) : -fabs(_moveSpeed);
+        _setVelocity((_target > _position) ? fabs(_moveSpeed) : -fabs(_moveSpeed));
     }
     long getTarget() const { return _target; }
 
@@ -103,44 +199,60 @@ public:
         return (_position == position);
     }
 
-    // Home using minimum switch (blocking). When pressed, position is set to 0.
-    // Moves slowly using moveSpeed. Returns true if homed, false if timed out.
-    bool homeBlocking(unsigned long timeoutMs = 0) {
+    // Homing speeds (steps/sec). The seek speed defaults to the move speed and the
+    // re-seek speed to an eighth of the seek speed.
+    void setHomingSpeeds(float seekSpeed, float reseekSpeed) {
+        _homeSeekSpeed = fabs(seekSpeed);
+        _homeReseekSpeed = fabs(reseekSpeed);
+    }
+    // Steps to move on after the switch releases, before the slow re-seek
+    void setHomingBackoff(long steps) { _homeBackoff = labs(steps); }
+
+    // Non-blocking homing: seek the min (or max) switch fast, back off, then re-seek it
+    // slowly. The position is set to `setPosition` when the slow re-seek closes the switch,
+    // so the result does not depend on the seek speed. update() runs the sequence; poll
+    // homingState() or isHoming(). timeoutMs = 0 waits forever.
+    void startHoming(bool towardMax = false, long setPosition = 0, unsigned long timeoutMs = 0) {
         if (!_enabled) enable();
-        unsigned long start = millis();
-        // Step toward min switch (assume min is reverse direction)
-        _velocity = -fabs(_moveSpeed);
-        _autoMove = false; // use continuous velocity mode for blocking homing
-        while (!minPressed()) {
-            update();
-            if (timeoutMs && (millis() - start) >= timeoutMs) { stop(); return false; }
-        }
+        _autoMove = false; // homing drives the continuous velocity mode
+        _phase = PHASE_IDLE;
+        _homeToMax = towardMax;
+        _homeSetPosition = setPosition;
+        _homeStart = millis();
+        _homeTimeout = timeoutMs;
+        _homeState = HOMING_SEEK;
+        _setVelocity(_homeDirection(true) * _seekSpeed());
+    }
+    HomingState homingState() const { return (HomingState)_homeState; }
+    bool isHoming() const { return _homeState > HOMING_IDLE && _homeState < HOMING_DONE; }
+    // Abandon homing; the position is left unchanged
+    void cancelHoming() {
+        if (!isHoming()) return;
         stop();
-        _position = 0;
-        _target = _position;
-        return true;
+        _homeState = HOMING_IDLE;
+    }
+
+    // Home using minimum switch (blocking). When pressed, position is set to 0.
+    // Returns true if homed, false if timed out.
+    bool homeBlocking(unsigned long timeoutMs = 0) {
+        startHoming(false, 0, timeoutMs);
+        while (isHoming()) update();
+        return _homeState == HOMING_DONE;
     }
 
     // Go to maximum switch (blocking). When pressed, position is set to provided pos (optional).
     bool gotoMaxBlocking(long setPositionWhenMax = 0, unsigned long timeoutMs = 0) {
-        if (!_enabled) enable();
-        unsigned long start = millis();
-        _velocity = fabs(_moveSpeed);
-        _autoMove = false;
-        while (!maxPressed()) {
-            update();
-            if (timeoutMs && (millis() - start) >= timeoutMs) { stop(); return false; }
-        }
-        stop();
-        _position = setPositionWhenMax;
-        _target = _position;
-        return true;
+        startHoming(true, setPositionWhenMax, timeoutMs);
+        while (isHoming()) update();
+        return _homeState == HOMING_DONE;
     }
 
     // Stop any motion
     void stop() {
-        _velocity = 0.0f;
+        _setVelocity(0.0f);
         _autoMove = false;
+        _phase = PHASE_IDLE;
+        _n = 0.0f;
     }
 
     // Call frequently from loop(). Pass micros() if available to reduce calls.
@@ -148,10 +260,15 @@ public:
         if (!_enabled) return;
         if (nowMicros == 0) nowMicros = micros();
 
+        if (isHoming() && !_updateHoming()) return;
+
+        if (_autoMove && _accel > 0.0f) { _updateProfiled(nowMicros); return; }
+
         // If automatic moveTo active, ensure velocity points toward target
         if (_autoMove) {
             if (_position == _target) { stop(); return; }
-            _velocity = (_target > _position) ? fabs(_moveSpeed) : -fabs(_moveSpeed);
+            bool forward = _target > _position;
+            if (forward != (_velocity > 0)) _setVelocity(forward ? fabs(_moveSpeed) : -fabs(_moveSpeed));
         }
 
         if (fabs(_velocity) < 1e-6) return; // no motion
@@ -163,11 +280,10 @@ public:
             return;
         }
 
-        unsigned long interval = (unsigned long)(1000000.0f / fabs(_velocity));
         if (_lastStepMicros == 0) _lastStepMicros = nowMicros;
-        if ((nowMicros - _lastStepMicros) >= interval) {
+        if ((nowMicros - _lastStepMicros) >= _interval) {
             // perform one step
-            digitalWrite(_dirPin, movingForward ? HIGH : LOW);
+            _writeDir(movingForward);
             _pulseStep();
             _position += movingForward ? 1 : -1;
             _lastStepMicros = nowMicros;
@@ -181,38 +297,235 @@ public:
         }
     }
 
+    // Steps driven from outside update() (StepperGroup). stepPrepare() checks the enable
+    // state and the limit switch and sets the direction; returns false if blocked.
+    // stepPin() writes the step pin, stepDone() counts the step.
+    bool stepPrepare(bool forward) {
+        if (!_enabled || !_canStepInDirection(forward)) return false;
+        _writeDir(forward);
+        return true;
+    }
+    void stepPin(bool high) { _pins.step(high); }
+    void stepDone(bool forward) { _position += forward ? 1 : -1; }
+
     // Position access
     long getPosition() const { return _position; }
     void setPosition(long pos) { _position = pos; }
 
     // Switch states
-    bool minPressed() const {
-        bool val = digitalRead(_minPin);
-        return _switchActiveLow ? (val == LOW) : (val == HIGH);
-    }
-    bool maxPressed() const {
-        bool val = digitalRead(_maxPin);
-        return _switchActiveLow ? (val == LOW) : (val == HIGH);
-    }
+    bool minPressed() const { return _pins.minPressed(); }
+    bool maxPressed() const { return _pins.maxPressed(); }
 
 private:
-    uint8_t _enablePin, _stepPin, _dirPin, _minPin, _maxPin;
-    bool _switchActiveLow;
+    enum { DIR_REVERSE = 0, DIR_FORWARD = 1, DIR_UNKNOWN = 2 };
+
+    Pins _pins;
     volatile long _position;
     volatile long _target;
     bool _enabled;
     bool _direction;
+    uint8_t _dirWritten; // level last written to the dir pin
     float _velocity;     // signed steps/sec for continuous movement
     float _moveSpeed;    // speed used for moveTo/home (positive)
     bool _autoMove;      // true if moveTo is driving motion
     unsigned long _lastStepMicros;
     unsigned int _stepPulseMicros;
+    unsigned long _interval; // microseconds per step at _velocity
+
+    // Accelerated moveTo() state. The speed is tracked as n = v^2 / (2 * accel), i.e. the
+    // number of steps needed to stop, and the step interval c is updated incrementally
+    // each step (D. Austin's approximation c' = c - 2c / (4n + 1) for the trapezoid) instead
+    // of computing 1e6 / v.
+    enum Phase { PHASE_IDLE, PHASE_ACCEL, PHASE_CRUISE, PHASE_DECEL };
+    float _accel;
+    Profile _profile;
+    Phase _phase;
+    float _n;            // current speed index
+    float _nMax;         // speed index at _moveSpeed
+    float _c;            // current step interval (us)
+    float _c0;           // first step interval from rest (us)
+    float _cMin;         // step interval at _moveSpeed (us)
+    long _rampStep;      // steps taken in the current S-curve ramp
+    float _rampLength;   // length of the current S-curve ramp (steps)
+    float _rampN0;       // speed index when the current ramp started
+    bool _profileForward;
+
+    // Homing state
+    uint8_t _homeState;
+    bool _homeToMax;
+    long _homeSetPosition;
+    unsigned long _homeStart;
+    unsigned long _homeTimeout;
+    float _homeSeekSpeed;
+    float _homeReseekSpeed;
+    long _homeBackoff;
+    long _homeBackoffFrom;   // position where the back-off started
+
+    void _setVelocity(float stepsPerSec) {
+        _velocity = stepsPerSec;
+        _interval = (fabs(stepsPerSec) < 1e-6) ? 0 : (unsigned long)(1000000.0f / fabs(stepsPerSec));
+    }
+
+    void _updateProfileLimits() {
+        if (_accel <= 0.0f || _moveSpeed <= 0.0f) return;
+        // Whole steps, so a deceleration from cruise ends exactly on the target
+        _nMax = floorf(_moveSpeed * _moveSpeed / (2.0f * _accel));
+        _cMin = 1000000.0f / _moveSpeed;
+        _c0 = 0.676f * sqrt(2.0f / _accel) * 1000000.0f; // Austin's corrected first interval
+        if (_c0 < _cMin) _c0 = _cMin;
+    }
+
+    void _startRamp(Phase phase) {
+        _phase = phase;
+        _rampStep = 0;
+        _rampN0 = _n;
+        // S-curve ramps use 1.5x the distance of a linear ramp so the peak acceleration
+        // (in the middle of the ramp) equals _accel.
+        float span = (phase == PHASE_ACCEL) ? (_nMax - _n) : _n;
+        _rampLength = 1.5f * span;
+    }
+
+    // Steps needed to come to rest from the current speed
+    float _stopDistance() const {
+        if (_profile != PROFILE_SCURVE) return _n;
+        return (_phase == PHASE_DECEL) ? _rampLength - _rampStep : 1.5f * _n;
+    }
+
+    void _updateProfiled(unsigned long nowMicros) {
+        if (_phase == PHASE_IDLE) {
+            if (_position == _target) { stop(); return; }
+            // Start from rest towards the target
+            _profileForward = _target > _position;
+            // Trapezoid: Austin's recurrence starts at n = 0 with the corrected _c0.
+            // S-curve: start at the speed index that matches _c0 so c and n stay consistent.
+            _n = (_profile == PROFILE_SCURVE) ? 1.0f / (4.0f * 0.676f * 0.676f) : 0.0f;
+            _c = _c0;
+            _lastStepMicros = nowMicros;
+            _startRamp(PHASE_ACCEL);
+        }
+        if ((nowMicros - _lastStepMicros) < (unsigned long)_c) return;
+
+        if (!_canStepInDirection(_profileForward)) { stop(); return; }
+        _writeDir(_profileForward);
+        _pulseStep();
+        _position += _profileForward ? 1 : -1;
+        _lastStepMicros = nowMicros;
+        if (minPressed() && _position < 0) _position = 0;
+
+        _nextInterval();
+    }
+
+    // Advance the speed index by one step and derive the next interval from it.
+    void _nextInterval() {
+        long remaining = _target - _position;
+        if (!_profileForward) remaining = -remaining; // steps left in the travel direction
+
+        if (remaining == 0 && _n <= 1.0f) { stop(); return; }
+
+        // Decelerate when the target is behind us or too close to stop otherwise
+        if (remaining <= 0 || _stopDistance() >= remaining) {
+            if (_phase != PHASE_DECEL) _startRamp(PHASE_DECEL);
+        } else if (_n < _nMax) {
+            if (_phase != PHASE_ACCEL) _startRamp(PHASE_ACCEL);
+        } else if (_phase != PHASE_CRUISE) {
+            _phase = PHASE_CRUISE;
+        }
+
+        float dn;
+        if (_phase == PHASE_CRUISE) {
+            _n = _nMax;
+            _c = _cMin;
+        } else {
+            if (_profile == PROFILE_SCURVE && _rampLength > 0.0f) {
+                float x = (_rampStep + 0.5f) / _rampLength;
+                if (x > 1.0f) x = 1.0f;
+                dn = 4.0f * x * (1.0f - x); // slope of smoothstep, scaled to a peak of 1
+                if (_phase == PHASE_ACCEL && dn < 0.05f) dn = 0.05f; // get going from rest
+            } else {
+                dn = 1.0f;
+                // One step short of where the ramps meet: hold the speed for a step so the
+                // deceleration starts from the same index the acceleration ended on
+                if (_phase == PHASE_ACCEL && _n + 1.0f >= remaining) dn = 0.0f;
+            }
+            if (_phase == PHASE_DECEL) dn = -dn;
+            _rampStep++;
+
+            float n = _n + dn;
+            if (n > _nMax) { n = _nMax; dn = _nMax - _n; }
+            if (n < 0.0f) { n = 0.0f; dn = -_n; }
+            if (_profile == PROFILE_SCURVE) {
+                // c scales with sqrt(n_old / n_new); Pade form stays accurate for fractional dn
+                _c = _c * (3.0f * _n + n) / (_n + 3.0f * n);
+            } else {
+                // Decelerating runs the acceleration recurrence backwards
+                if (dn < 0.0f) _c = _c * (4.0f * _n + 1.0f) / (4.0f * _n - 1.0f);
+                else _c = _c - 2.0f * _c * dn / (4.0f * n + 1.0f);
+            }
+            _n = n;
+            if (_c < _cMin) _c = _cMin;
+            if (_c > _c0) _c = _c0;
+        }
+
+        // Reached rest while reversing: restart towards the target from standstill
+        if (_phase == PHASE_DECEL && _n <= 0.0f && remaining <= 0) {
+            _phase = PHASE_IDLE;
+            if (_position == _target) { stop(); return; }
+        }
+    }
+
+    float _seekSpeed() const { return _homeSeekSpeed > 0.0f ? _homeSeekSpeed : _moveSpeed; }
+    float _reseekSpeed() const { return _homeReseekSpeed > 0.0f ? _homeReseekSpeed : _seekSpeed() / 8.0f; }
+    // +1/-1 velocity sign towards (or away from) the homing switch
+    float _homeDirection(bool towardSwitch) const { return (_homeToMax == towardSwitch) ? 1.0f : -1.0f; }
+    bool _homeSwitchPressed() const { return _homeToMax ? maxPressed() : minPressed(); }
+
+    // One homing step of update(): sets the velocity for the current phase. Returns false
+    // when homing ended on this call and no step should be taken.
+    bool _updateHoming() {
+        if (_homeTimeout && (millis() - _homeStart) >= _homeTimeout) {
+            stop();
+            _homeState = HOMING_FAILED;
+            return false;
+        }
+        bool pressed = _homeSwitchPressed();
+        switch (_homeState) {
+        case HOMING_SEEK:
+            if (!pressed) return true;
+            _homeBackoffFrom = _position;
+            _homeState = HOMING_BACKOFF;
+            _setVelocity(_homeDirection(false) * _seekSpeed());
+            return true;
+        case HOMING_BACKOFF:
+            // The switch counts as clear only after it released and the distance is covered
+            if (pressed) { _homeBackoffFrom = _position; return true; }
+            if (labs(_position - _homeBackoffFrom) < _homeBackoff) return true;
+            _homeState = HOMING_RESEEK;
+            _setVelocity(_homeDirection(true) * _reseekSpeed());
+            return true;
+        case HOMING_RESEEK:
+            if (!pressed) return true;
+            stop();
+            _position = _homeSetPosition;
+            _target = _position;
+            _homeState = HOMING_DONE;
+            return false;
+        default:
+            return true;
+        }
+    }
+
+    // The dir pin is only written when the direction changes
+    void _writeDir(bool forward) {
+        if (_dirWritten == (forward ? DIR_FORWARD : DIR_REVERSE)) return;
+        _pins.dir(forward);
+        _dirWritten = forward ? DIR_FORWARD : DIR_REVERSE;
+    }
 
     // Pulse the step pin (blocking small delay)
     void _pulseStep() {
-        digitalWrite(_stepPin, HIGH);
-        delayMicroseconds(_stepPulseMicros);
-        digitalWrite(_stepPin, LOW);
+        _pins.step(true);
+        if (_stepPulseMicros) delayMicroseconds(_stepPulseMicros);
+        _pins.step(false);
     }
 
     // Check if it's allowed to step in requested direction given limit switches
@@ -223,4 +536,13 @@ private:
     }
 };
 
+class Stepper : public BasicStepper<StepperPins> {
+public:
+    Stepper(uint8_t stepPin, uint8_t dirPin,
+            uint8_t minSwitchPin, uint8_t maxSwitchPin = 0, uint8_t enablePin = 0,
+            bool switchesActiveLow = true)
+        : BasicStepper<StepperPins>(StepperPins(stepPin, dirPin, minSwitchPin, maxSwitchPin,
+                                                enablePin, switchesActiveLow)) {}
+};
+
 #endif // STEPper_H
\ No newline at end of file
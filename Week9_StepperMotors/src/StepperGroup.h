@@ -0,0 +1,202 @@
+// StepperGroup.h
+// Coordinated straight-line moves for several steppers on one time base.
+//
+// The group drives the axes itself, without their update():
+//  - One major-axis step per tick. The axis with the longest travel is the major axis,
+//    and a Bresenham counter per axis decides which other axes step on the same tick.
+//    Every axis therefore starts and finishes together on a straight line.
+//  - The tick interval is computed once per tick for the whole group: the path speed and
+//    acceleration are scaled to the major axis and ramped with the same recurrence as
+//    Stepper::moveTo(): c' = c - 2c / (4n' + 1) while accelerating, and its inverse,
+//    c' = c (4n + 1) / (4n - 1), while decelerating.
+//  - All step pins go high and low together, with one pulse delay. With setStepPort() the
+//    step pins of the axes on the same port are written in one port access.
+//
+// Axes can be any mix of Stepper and FastStepper. Do not call an axis's update() while the
+// group is moving it.
+
+#ifndef STEPPER_GROUP_H
+#define STEPPER_GROUP_H
+
+#include <Arduino.h>
+#include <math.h>
+#include "Stepper.h"
+
+template <uint8_t N>
+class StepperGroup {
+    static_assert(N >= 1 && N <= 8, "StepperGroup: 1 to 8 axes");
+
+public:
+    StepperGroup()
+        : _count(0), _speed(500.0f), _accel(0.0f), _stepPulseMicros(1), _port(NULL),
+          _moving(false), _limitHit(false), _major(0), _done(0), _n(0.0f), _nMax(0.0f),
+          _c(0.0f), _c0(0.0f), _cMin(0.0f), _lastStepMicros(0) {}
+
+    // Add an axis; returns its index, or -1 when the group is full
+    template <class S>
+    int8_t addAxis(S& stepper) {
+        if (_count >= N) return -1;
+        Axis& a = _axes[_count];
+        a.stepper = &stepper;
+        a.prepare = &_callPrepare<S>;
+        a.pin = &_callPin<S>;
+        a.done = &_callDone<S>;
+        a.position = &_callPosition<S>;
+        a.portMask = 0;
+        return (int8_t)_count++;
+    }
+
+    // Speed along the path (steps/sec) and acceleration (steps/sec^2, 0 = none)
+    void setSpeed(float stepsPerSec) { _speed = fabs(stepsPerSec); }
+    void setAcceleration(float stepsPerSec2) { _accel = fabs(stepsPerSec2); }
+    void setStepPulseWidth(unsigned int microsPulse) { _stepPulseMicros = microsPulse; }
+
+    // Write the step pins of the axes with a non-zero mask (one per axis, in addAxis()
+    // order) in one access to `port`. Pass NULL to go back to per-axis writes.
+    void setStepPort(volatile uint8_t* port, const uint8_t* masks) {
+        _port = port;
+        for (uint8_t i = 0; i < _count; i++) _axes[i].portMask = port ? masks[i] : 0;
+    }
+
+    // Start a straight move to targets[] (one per axis). Returns false if already there.
+    bool moveTo(const long* targets) {
+        float lengthSqr = 0.0f;
+        _major = 0;
+        for (uint8_t i = 0; i < _count; i++) {
+            Axis& a = _axes[i];
+            long d = targets[i] - a.position(a.stepper);
+            a.forward = d > 0;
+            a.steps = (unsigned long)labs(d);
+            lengthSqr += (float)d * (float)d;
+            if (a.steps > _major) _major = a.steps;
+        }
+        _limitHit = false;
+        if (_major == 0 || _speed <= 0.0f) { _moving = false; return false; }
+        for (uint8_t i = 0; i < _count; i++) _axes[i].counter = -(long)(_major >> 1);
+
+        // Path speed/acceleration as major-axis step rates
+        float scale = (float)_major / sqrt(lengthSqr);
+        float v = _speed * scale;
+        _cMin = 1000000.0f / v;
+        if (_accel > 0.0f) {
+            float a = _accel * scale;
+            _nMax = floorf(v * v / (2.0f * a)); // whole steps, so the ramps mirror each other
+            _c0 = 0.676f * sqrt(2.0f / a) * 1000000.0f;
+            if (_c0 < _cMin) _c0 = _cMin;
+        } else {
+            _nMax = 0.0f;
+            _c0 = _cMin;
+        }
+        _n = 0.0f;
+        _c = _c0;
+        _done = 0;
+        _lastStepMicros = micros() - (unsigned long)_c; // first step on the next update()
+        _moving = true;
+        return true;
+    }
+
+    void stop() { _moving = false; }
+    bool isMoving() const { return _moving; }
+    // True if the last move was cut short by a limit switch
+    bool limitHit() const { return _limitHit; }
+
+    // Call frequently from loop(). Pass micros() if available.
+    void update(unsigned long nowMicros = 0) {
+        if (!_moving) return;
+        if (nowMicros == 0) nowMicros = micros();
+        if ((nowMicros - _lastStepMicros) < (unsigned long)_c) return;
+        _lastStepMicros = nowMicros;
+
+        // Axes stepping on this tick
+        uint8_t stepping = 0;
+        for (uint8_t i = 0; i < _count; i++) {
+            Axis& a = _axes[i];
+            a.counter += a.steps;
+            if (a.counter > 0) {
+                a.counter -= _major;
+                if (!a.prepare(a.stepper, a.forward)) {
+                    // A blocked axis would bend the line: end the whole move here
+                    _limitHit = true;
+                    _moving = false;
+                    return;
+                }
+                stepping |= 1 << i;
+            }
+        }
+
+        uint8_t portBits = 0;
+        for (uint8_t i = 0; i < _count; i++) {
+            if (!(stepping & (1 << i))) continue;
+            if (_axes[i].portMask) portBits |= _axes[i].portMask;
+            else _axes[i].pin(_axes[i].stepper, true);
+        }
+        if (portBits) *_port |= portBits;
+        if (_stepPulseMicros) delayMicroseconds(_stepPulseMicros);
+        if (portBits) *_port &= ~portBits;
+        for (uint8_t i = 0; i < _count; i++) {
+            if (!(stepping & (1 << i))) continue;
+            if (!_axes[i].portMask) _axes[i].pin(_axes[i].stepper, false);
+            _axes[i].done(_axes[i].stepper, _axes[i].forward);
+        }
+
+        if (++_done >= _major) { _moving = false; return; }
+        _nextInterval();
+    }
+
+private:
+    struct Axis {
+        void* stepper;
+        bool (*prepare)(void*, bool);
+        void (*pin)(void*, bool);
+        void (*done)(void*, bool);
+        long (*position)(void*);
+        uint8_t portMask;
+        bool forward;
+        unsigned long steps; // travel of the current move
+        long counter;        // Bresenham error term
+    };
+
+    Axis _axes[N];
+    uint8_t _count;
+    float _speed;
+    float _accel;
+    unsigned int _stepPulseMicros;
+    volatile uint8_t* _port;
+    bool _moving;
+    bool _limitHit;
+    unsigned long _major; // major-axis steps of the move
+    unsigned long _done;  // major-axis steps taken
+    float _n;             // speed index (major-axis steps needed to stop)
+    float _nMax;
+    float _c;             // current tick interval (us)
+    float _c0;
+    float _cMin;
+    unsigned long _lastStepMicros;
+
+    template <class S> static bool _callPrepare(void* s, bool forward) { return static_cast<S*>(s)->stepPrepare(forward); }
+    template <class S> static void _callPin(void* s, bool high) { static_cast<S*>(s)->stepPin(high); }
+    template <class S> static void _callDone(void* s, bool forward) { static_cast<S*>(s)->stepDone(forward); }
+    template <class S> static long _callPosition(void* s) { return static_cast<S*>(s)->getPosition(); }
+
+    // Trapezoid on the major axis: decelerate once the remaining steps only just cover
+    // the stop distance, otherwise accelerate up to the cruise speed
+    void _nextInterval() {
+        if (_accel <= 0.0f) return;
+        float remaining = (float)(_major - _done);
+        float dn;
+        if (_n >= remaining) dn = -1.0f;
+        else if (_n < _nMax) dn = 1.0f;
+        else return;
+        float n = _n + dn;
+        if (n > _nMax) { n = _nMax; dn = _nMax - _n; }
+        if (n < 0.0f) { n = 0.0f; dn = -_n; }
+        // Decelerating runs the acceleration recurrence backwards
+        if (dn < 0.0f) _c = _c * (4.0f * _n + 1.0f) / (4.0f * _n - 1.0f);
+        else _c = _c - 2.0f * _c * dn / (4.0f * n + 1.0f);
+        _n = n;
+        if (_c < _cMin) _c = _cMin;
+        if (_c > _c0) _c = _c0;
+    }
+};
+
+#endif // STEPPER_GROUP_H
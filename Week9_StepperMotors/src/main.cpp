@@ -1,25 +1,60 @@
 #include <Arduino.h>
-#include "Stepper.h"
+#include "FastStepper.h"
+#include "StepperGroup.h"
+#if STEP_RATE_BENCH
+#include "StepRateBench.h"
+#endif
 
-Stepper xAxis = Stepper(5, 4, 3, 2, 12);
-Stepper yAxis = Stepper(6, 7, 10, 9, 8);
+#ifndef STEP_RATE_BENCH
+#define STEP_RATE_BENCH 0 // 1 = print the step rate benchmark over serial instead of running
+#endif
+
+// Pins are template arguments: step, dir, min switch, max switch, enable
+FastStepper<5, 4, 3, 2, 12> xAxis;
+FastStepper<6, 7, 10, 9, 8> yAxis;
+
+// Both axes home at the same time, then move together on a straight line
+StepperGroup<2> axes;
+bool homed = false;
 
 void setup() {
   // put your setup code here, to run once:
+#if STEP_RATE_BENCH
+  Serial.begin(115200);
+  StepRateBench::run(Serial);
+  while (true) {
+    delay(1000);
+  }
+#endif
   xAxis.begin();
   xAxis.enable(); 
-  xAxis.homeBlocking();
-  xAxis.moveTo(600);
+  xAxis.startHoming(false, 0, 20000);
   yAxis.begin();
   yAxis.enable(); 
-  yAxis.homeBlocking();
-  yAxis.moveTo(900);
+  yAxis.startHoming(false, 0, 20000);
+
+  axes.addAxis(xAxis);
+  axes.addAxis(yAxis);
+  axes.setSpeed(500);
+#if FAST_STEPPER_PORTS
+  // Both step pins are on port D: pulse them with one write
+  const uint8_t stepMasks[] = {AvrPin<5>::bit, AvrPin<6>::bit};
+  axes.setStepPort(&AvrPin<5>::out(), stepMasks);
+#endif
 }
 
 void loop() {
+  if (homed) {
+    axes.update();
+    return;
+  }
   unsigned long nowMicros = micros();
   xAxis.update(nowMicros);
-  nowMicros = micros();
   yAxis.update(nowMicros);
-  
+  if (xAxis.isHoming() || yAxis.isHoming()) return;
+  homed = true;
+  if (xAxis.homingState() == StepperBase::HOMING_DONE && yAxis.homingState() == StepperBase::HOMING_DONE) {
+    const long target[] = {600, 900};
+    axes.moveTo(target);
+  }
 }
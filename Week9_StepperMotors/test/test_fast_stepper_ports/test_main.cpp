@@ -0,0 +1,132 @@
+// test_fast_stepper_ports
+// Host build of FastStepper's direct port path (pio test -e native). The ATmega328P
+// registers are plain variables here, so this checks that the FAST_STEPPER_PORTS code
+// compiles and maps each pin to the right port and bit, sets up the pull-ups and
+// pin-change interrupts, and keeps the switch flags in step with the pins. It says
+// nothing about the code avr-gcc generates or the step rate on the Uno.
+
+#include <Arduino.h>
+#include <unity.h>
+
+// ATmega328P register stand-ins
+static volatile uint8_t PORTB, PORTC, PORTD;
+static volatile uint8_t PINB, PINC, PIND;
+static volatile uint8_t DDRB, DDRC, DDRD;
+static volatile uint8_t PCMSK0, PCMSK1, PCMSK2;
+static volatile uint8_t PCICR, PCIFR;
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define ISR(vector, ...) void vector(void)
+#define ISR_ALIASOF(vector)
+
+#define FAST_STEPPER_PORTS 1
+#include "FastStepper.h"
+
+// The sketch's x axis: step 5 (PD5), dir 4 (PD4), min 3 (PD3), max 2 (PD2), enable 12 (PB4)
+typedef FastStepper<5, 4, 3, 2, 12> XAxis;
+// Pins on all three ports: step 6 (PD6), dir 7 (PD7), min 10 (PB2), max 15 (A1, PC1)
+typedef FastStepper<6, 7, 10, 15> YAxis;
+
+static void clearRegisters() {
+    PORTB = PORTC = PORTD = 0;
+    PINB = PINC = PIND = 0;
+    DDRB = DDRC = DDRD = 0;
+    PCMSK0 = PCMSK1 = PCMSK2 = 0;
+    PCICR = PCIFR = 0;
+}
+
+void setUp(void) { clearRegisters(); }
+void tearDown(void) {}
+
+void test_pins_map_to_port_and_bit(void) {
+    TEST_ASSERT_TRUE(&AvrPin<0>::out() == &PORTD);
+    TEST_ASSERT_TRUE(&AvrPin<7>::in() == &PIND);
+    TEST_ASSERT_TRUE(&AvrPin<8>::out() == &PORTB);
+    TEST_ASSERT_TRUE(&AvrPin<13>::ddr() == &DDRB);
+    TEST_ASSERT_TRUE(&AvrPin<14>::in() == &PINC);
+    TEST_ASSERT_TRUE(&AvrPin<19>::pcmsk() == &PCMSK1);
+    TEST_ASSERT_EQUAL_HEX8(1 << 5, AvrPin<5>::bit);
+    TEST_ASSERT_EQUAL_HEX8(1 << 0, AvrPin<8>::bit);
+    TEST_ASSERT_EQUAL_HEX8(1 << 4, AvrPin<12>::bit);
+    TEST_ASSERT_EQUAL_HEX8(1 << 5, AvrPin<19>::bit);
+    TEST_ASSERT_EQUAL_INT(PCIE2, AvrPin<3>::pcie);
+    TEST_ASSERT_EQUAL_INT(PCIE0, AvrPin<10>::pcie);
+    TEST_ASSERT_EQUAL_INT(PCIE1, AvrPin<15>::pcie);
+}
+
+void test_begin_sets_directions_pullups_and_pin_change(void) {
+    PIND = 0x0C; // both switches open (pulled up)
+    XAxis x;
+    x.begin();
+    TEST_ASSERT_EQUAL_HEX8(0x30, DDRD);         // step and dir outputs, switches inputs
+    TEST_ASSERT_EQUAL_HEX8(0x10, DDRB);         // enable output
+    TEST_ASSERT_EQUAL_HEX8(0x0C, PORTD & 0x0C); // switch pull-ups
+    TEST_ASSERT_EQUAL_HEX8(0x0C, PCMSK2);
+    TEST_ASSERT_EQUAL_HEX8(1 << PCIE2, PCICR);
+    TEST_ASSERT_FALSE(x.minPressed());
+    TEST_ASSERT_FALSE(x.maxPressed());
+}
+
+void test_switch_flags_follow_pin_change(void) {
+    PIND = 0x0C;
+    PINB = 1 << 2;
+    PINC = 1 << 1;
+    XAxis x;
+    YAxis y;
+    x.begin();
+    y.begin();
+    TEST_ASSERT_EQUAL_HEX8((1 << PCIE0) | (1 << PCIE1) | (1 << PCIE2), PCICR);
+
+    // Flags only change when the vector runs, like on the chip
+    PIND &= ~(1 << 3);
+    TEST_ASSERT_FALSE(x.minPressed());
+    PCINT0_vect();
+    TEST_ASSERT_TRUE(x.minPressed());
+    TEST_ASSERT_FALSE(x.maxPressed());
+
+    PINC &= ~(1 << 1);
+    PCINT0_vect();
+    TEST_ASSERT_TRUE(y.maxPressed());
+    TEST_ASSERT_FALSE(y.minPressed());
+
+    PIND |= 1 << 3;
+    PINC |= 1 << 1;
+    PCINT0_vect();
+    TEST_ASSERT_FALSE(x.minPressed());
+    TEST_ASSERT_FALSE(y.maxPressed());
+}
+
+void test_steps_write_step_and_dir_bits(void) {
+    PIND = 0x0C;
+    XAxis x;
+    x.begin();
+    x.enable();
+    TEST_ASSERT_EQUAL_HEX8(0, PORTB & 0x10); // enable is active low
+    x.setStepPulseWidth(0);
+    x.setVelocity(2000000.0f); // step on every update()
+    for (unsigned long t = 1; t <= 10; t++) x.update(t);
+    TEST_ASSERT_EQUAL_INT32(10, x.getPosition());
+    TEST_ASSERT_EQUAL_HEX8(0x10, PORTD & 0x30); // dir high, step back low
+
+    x.setVelocity(-2000000.0f);
+    for (unsigned long t = 11; t <= 14; t++) x.update(t);
+    TEST_ASSERT_EQUAL_INT32(6, x.getPosition());
+    TEST_ASSERT_EQUAL_HEX8(0x00, PORTD & 0x30);
+
+    // A closed max switch blocks forward steps
+    PIND &= ~(1 << 2);
+    PCINT0_vect();
+    x.setVelocity(2000000.0f);
+    x.update(20);
+    TEST_ASSERT_EQUAL_INT32(6, x.getPosition());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_pins_map_to_port_and_bit);
+    RUN_TEST(test_begin_sets_directions_pullups_and_pin_change);
+    RUN_TEST(test_switch_flags_follow_pin_change);
+    RUN_TEST(test_steps_write_step_and_dir_bits);
+    return UNITY_END();
+}
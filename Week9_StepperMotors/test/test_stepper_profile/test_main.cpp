@@ -0,0 +1,175 @@
+// test_stepper_profile
+// Host tests for the trapezoidal moveTo() profile (pio test -e native): the step
+// intervals from the incremental recurrence are compared with the exact timing of a
+// constant-acceleration move, t(x) = sqrt(2x / a), over the acceleration, cruise and
+// deceleration phases and for moves too short to reach cruise. StepperGroup ramps its
+// major axis with the same recurrence and is checked the same way.
+
+#include <Arduino.h>
+#include <unity.h>
+#include "Stepper.h"
+#include "StepperGroup.h"
+
+#define MAX_STEPS 2000
+
+// interval[k]: microseconds from step k to step k + 1 (interval[0] is from the start)
+static unsigned long interval[MAX_STEPS + 1];
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Run a move of `distance` steps from rest, stepping exactly when update() is due
+static void runMove(float accel, float speed, long distance) {
+    Stepper stepper(2, 3, 4);
+    stepper.begin();
+    stepper.enable();
+    stepper.setStepPulseWidth(0);
+    stepper.setAcceleration(accel);
+    stepper.setMoveSpeed(speed);
+
+    unsigned long now = 1000;
+    stepper.moveTo(distance);
+    stepper.update(now);
+    for (long k = 0; k < distance; k++) {
+        interval[k] = stepper.getStepInterval();
+        now += interval[k];
+        stepper.update(now);
+        TEST_ASSERT_EQUAL_INT32(k + 1, stepper.getPosition());
+    }
+}
+
+// Same move through a one-axis StepperGroup, with update() called every microsecond
+static void runGroupMove(float accel, float speed, long distance) {
+    Stepper stepper(2, 3, 4);
+    stepper.begin();
+    stepper.enable();
+    StepperGroup<1> group;
+    group.addAxis(stepper);
+    group.setStepPulseWidth(0);
+    group.setAcceleration(accel);
+    group.setSpeed(speed);
+
+    const long target[] = {distance};
+    TEST_ASSERT_TRUE(group.moveTo(target));
+    unsigned long now = micros();
+    unsigned long last = 0;
+    long k = -1;
+    while (group.isMoving()) {
+        group.update(now);
+        long position = stepper.getPosition();
+        if (position > k + 1) {
+            TEST_ASSERT_EQUAL_INT32(k + 2, position);
+            if (k >= 0) interval[k] = now - last;
+            last = now;
+            k++;
+        }
+        now++;
+    }
+    TEST_ASSERT_EQUAL_INT32(distance, stepper.getPosition());
+}
+
+// Exact time (us) at which position x is passed on a trapezoid (or triangle) from rest
+// to rest over `distance` steps
+static double exactTime(float accel, float speed, long distance, double x) {
+    double ramp = speed * (double)speed / (2.0 * accel);
+    if (ramp > distance / 2.0) ramp = distance / 2.0;
+    double peak = sqrt(2.0 * accel * ramp);
+    double total = 2.0 * peak / accel + (distance - 2.0 * ramp) / peak;
+    double t;
+    if (x <= ramp) t = sqrt(2.0 * x / accel);
+    else if (x <= distance - ramp) t = peak / accel + (x - ramp) / peak;
+    else t = total - sqrt(2.0 * (distance - x) / accel);
+    return t * 1e6;
+}
+
+static double exactInterval(float accel, float speed, long distance, long k) {
+    return exactTime(accel, speed, distance, k + 1) - exactTime(accel, speed, distance, k);
+}
+
+// Intervals k in [from, to] within `tolerance` (relative) of the exact timing
+static void checkIntervals(float accel, float speed, long distance, long from, long to, double tolerance) {
+    char msg[64];
+    for (long k = from; k <= to; k++) {
+        double exact = exactInterval(accel, speed, distance, k);
+        snprintf(msg, sizeof(msg), "a=%g v=%g d=%ld k=%ld", accel, speed, distance, k);
+        TEST_ASSERT_FLOAT_WITHIN_MESSAGE(tolerance * exact + 1.0, exact, (double)interval[k], msg);
+    }
+}
+
+// Austin's recurrence is within about 2% of the exact intervals from the second step on
+static const double RAMP_TOLERANCE = 0.025;
+
+void test_acceleration_matches_exact_timing(void) {
+    const float accel = 800.0f, speed = 1000.0f; // 625 steps to reach speed
+    runMove(accel, speed, MAX_STEPS);
+    checkIntervals(accel, speed, MAX_STEPS, 1, 624, RAMP_TOLERANCE);
+}
+
+void test_cruise_runs_at_move_speed(void) {
+    const float accel = 800.0f, speed = 900.0f; // ramps of 506.25 steps
+    runMove(accel, speed, MAX_STEPS);
+    for (long k = 510; k < MAX_STEPS - 510; k++) {
+        TEST_ASSERT_FLOAT_WITHIN(1.0f, 1000000.0f / speed, (float)interval[k]);
+    }
+}
+
+void test_deceleration_matches_exact_timing(void) {
+    const float accel = 4000.0f, speed = 2000.0f; // 500 steps to stop
+    runMove(accel, speed, MAX_STEPS);
+    checkIntervals(accel, speed, MAX_STEPS, MAX_STEPS - 500, MAX_STEPS - 2, RAMP_TOLERANCE);
+    // The deceleration runs the acceleration backwards (up to float rounding)
+    for (long k = 1; k < 500; k++) {
+        TEST_ASSERT_FLOAT_WITHIN(0.001f * interval[k] + 1.0f, (float)interval[k], (float)interval[MAX_STEPS - 1 - k]);
+    }
+}
+
+void test_short_moves_never_reach_cruise(void) {
+    const float accel = 800.0f, speed = 2000.0f; // 2500 steps to reach speed
+    const long distances[] = {1001, 300, 41, 10, 4};
+    for (unsigned i = 0; i < sizeof(distances) / sizeof(distances[0]); i++) {
+        long d = distances[i];
+        runMove(accel, speed, d);
+        checkIntervals(accel, speed, d, 1, d - 2, RAMP_TOLERANCE);
+        for (long k = 0; k < d; k++) {
+            TEST_ASSERT_TRUE(interval[k] > 1000000.0f / speed);
+        }
+    }
+    // Three steps: the single interior interval straddles the peak
+    runMove(accel, speed, 3);
+    checkIntervals(accel, speed, 3, 1, 1, 0.10);
+}
+
+void test_first_and_last_interval_use_corrected_start(void) {
+    // Austin's first interval is 0.676 of the exact one so that the following ones match;
+    // the deceleration ends with the same interval
+    const float accel = 800.0f, speed = 1000.0f;
+    float c0 = 0.676f * sqrtf(2.0f / accel) * 1000000.0f;
+    runMove(accel, speed, 300);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, c0, (float)interval[0]);
+    TEST_ASSERT_FLOAT_WITHIN(2.0f, c0, (float)interval[299]);
+}
+
+void test_group_deceleration_mirrors_acceleration(void) {
+    // The group's first step starts the clock, so interval[k] here is the exact
+    // interval k + 1: from step k + 1 to step k + 2
+    const float accel = 4000.0f, speed = 2000.0f; // 500 steps to stop
+    runGroupMove(accel, speed, MAX_STEPS);
+    for (long k = 0; k < 498; k++) {
+        TEST_ASSERT_FLOAT_WITHIN(0.001f * interval[k] + 2.0f, (float)interval[k], (float)interval[MAX_STEPS - 3 - k]);
+    }
+    for (long k = MAX_STEPS - 500; k <= MAX_STEPS - 4; k++) {
+        double exact = exactInterval(accel, speed, MAX_STEPS, k + 1);
+        TEST_ASSERT_FLOAT_WITHIN(RAMP_TOLERANCE * exact + 1.0, exact, (double)interval[k]);
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_acceleration_matches_exact_timing);
+    RUN_TEST(test_cruise_runs_at_move_speed);
+    RUN_TEST(test_deceleration_matches_exact_timing);
+    RUN_TEST(test_short_moves_never_reach_cruise);
+    RUN_TEST(test_first_and_last_interval_use_corrected_start);
+    RUN_TEST(test_group_deceleration_mirrors_acceleration);
+    return UNITY_END();
+}